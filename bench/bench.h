@@ -0,0 +1,47 @@
+// (c) Copyright 2016, Sean Connelly (@voidqk), http://syntheti.cc
+// MIT License
+// Project Home: https://github.com/voidqk/sndfilter
+
+// small helpers shared by the benchmarks in this directory (see bench/build)
+
+#ifndef SNDFILTER_BENCH__H
+#define SNDFILTER_BENCH__H
+
+#include "../src/snd.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+// seconds on a monotonic clock
+static inline double bench_now(){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// uniform noise in [-1, 1) from a small LCG, so every run (and every machine) gets the same input
+static inline float bench_rand(uint32_t *seed){
+	*seed = *seed * 1664525u + 1013904223u;
+	return (float)(*seed >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+// allocate a stereo test signal: a few tones plus noise, with the level swinging slowly between
+// quiet and loud, so that dynamics processors move between attacking and releasing
+static inline sf_sample_st *bench_signal(int size, int rate){
+	sf_sample_st *s = malloc(sizeof(sf_sample_st) * size);
+	if (s == NULL)
+		return NULL;
+	uint32_t seed = 1;
+	for (int i = 0; i < size; i++){
+		double t = (double)i / rate;
+		float level = 0.05f + 0.95f * (float)(0.5 + 0.5 * sin(2.0 * M_PI * 0.37 * t));
+		float tones = (float)(0.3 * sin(2.0 * M_PI * 110.0 * t) +
+			0.2 * sin(2.0 * M_PI * 1234.5 * t));
+		s[i].L = level * (tones + 0.3f * bench_rand(&seed));
+		s[i].R = level * (tones * 0.8f + 0.3f * bench_rand(&seed));
+	}
+	return s;
+}
+
+#endif // SNDFILTER_BENCH__H
@@ -0,0 +1,70 @@
+// (c) Copyright 2016, Sean Connelly (@voidqk), http://syntheti.cc
+// MIT License
+// Project Home: https://github.com/voidqk/sndfilter
+
+// a cascade of biquads run as one sf_biquad_chain_st, against one sf_biquad_process pass per
+// section
+//
+// the sections are 31 peaking filters (one per third-octave, like a graphic EQ), over 30 seconds of
+// stereo; the chain's output should be identical to the separate passes, which is checked too
+//
+//   tgt/bench_chain [sections]
+
+#include "bench.h"
+#include "../src/biquad.h"
+#include <stdio.h>
+#include <string.h>
+
+#define RATE     44100
+#define SECONDS  30
+#define ROUNDS   5
+
+int main(int argc, char **argv){
+	int sections = argc > 1 ? atoi(argv[1]) : 31;
+	if (sections < 1)
+		sections = 1;
+	else if (sections > SF_BIQUAD_CHAIN_MAX)
+		sections = SF_BIQUAD_CHAIN_MAX;
+	int size = RATE * SECONDS;
+	sf_sample_st *input = bench_signal(size, RATE);
+	sf_sample_st *passes = malloc(sizeof(sf_sample_st) * size);
+	sf_sample_st *chained = malloc(sizeof(sf_sample_st) * size);
+
+	sf_biquad_chain_st design;
+	sf_biquad_chain_init(&design);
+	for (int i = 0; i < sections; i++){
+		// sf_peaking puts the peak at twice the frequency it is given
+		float freq = 20.0f * powf(2.0f, i / 3.0f);
+		sf_peaking(sf_biquad_chain_add(&design), RATE, freq * 0.5f, 4.3f,
+			i % 2 ? -3.0f : 3.0f);
+	}
+
+	double tpasses = 1e9, tchain = 1e9;
+	for (int r = 0; r < ROUNDS; r++){
+		sf_biquad_chain_st work = design;
+		double t = bench_now();
+		sf_biquad_process(&work.sections[0], size, input, passes);
+		for (int i = 1; i < sections; i++)
+			sf_biquad_process(&work.sections[i], size, passes, passes);
+		t = bench_now() - t;
+		if (t < tpasses)
+			tpasses = t;
+
+		work = design;
+		t = bench_now();
+		sf_biquad_chain_process(&work, size, input, chained);
+		t = bench_now() - t;
+		if (t < tchain)
+			tchain = t;
+	}
+
+	printf("%d sections, %ds at %dHz, best of %d\n", sections, SECONDS, RATE, ROUNDS);
+	printf("  separate passes  %.3fs\n", tpasses);
+	printf("  chain            %.3fs\n", tchain);
+	printf("  output %s\n", memcmp(passes, chained, sizeof(sf_sample_st) * size) == 0 ?
+		"identical" : "DIFFERENT");
+	free(input);
+	free(passes);
+	free(chained);
+	return 0;
+}
@@ -0,0 +1,134 @@
+// (c) Copyright 2016, Sean Connelly (@voidqk), http://syntheti.cc
+// MIT License
+// Project Home: https://github.com/voidqk/sndfilter
+
+// sf_compressor_process against sf_compressor_process_fast
+//
+// for a few settings, and a few samples per update (SPU), times both versions over 60 seconds of
+// stereo (in 128 sample calls), and measures how far apart the gain they apply gets; with no dry
+// mix, the output is the delayed input times the gain, so the ratio of the two outputs is the
+// ratio of the gains
+//
+// the test signal is run at its normal level (peaks around 0dB), and 24dB louder, which compresses
+// much harder
+//
+// then times the default setting with a few predelays, since the predelay buffer sits on the path
+// of every sample
+//
+//   tgt/bench_compressor
+
+#include "bench.h"
+#include "../src/compressor.h"
+#include <stdio.h>
+
+#define RATE     44100
+#define SECONDS  60
+#define ROUNDS   3
+#define CHUNK    128
+
+typedef struct {
+	const char *name;
+	float threshold;
+	float knee;
+	float ratio;
+	float attack;
+	float release;
+} setting_st;
+
+static const setting_st settings[] = {
+	{ "default",   -24.0f, 30.0f, 12.0f, 0.003f, 0.250f },
+	{ "hard knee", -30.0f,  0.0f, 20.0f, 0.001f, 0.100f },
+	{ "gentle",    -20.0f, 40.0f,  2.0f, 0.010f, 0.500f }
+};
+
+static const int spus[] = { 8, 32, 128 };
+
+// predelays in samples; 264 is the default of 0.006s at 44100Hz, and 1024 is the longest
+#define DEFPREDELAY  264
+static const int predelays[] = { 0, 1, 2, 264, 1000, 1024 };
+
+static void init(sf_compressor_state_st *state, const setting_st *s, int spu, int predelay){
+	// the predelay is given in samples, and nudged by half a sample so it doesn't round down
+	if (!sf_advancecomp(state, RATE, 0.0f, s->threshold, s->knee, s->ratio, s->attack, s->release,
+		(predelay + 0.5f) / RATE, 0.09f, 0.16f, 0.42f, 0.98f, 0.0f, 1.0f, spu)){
+		printf("out of memory\n");
+		exit(1);
+	}
+}
+
+// process the whole input in CHUNK sized calls, returning the best time of ROUNDS
+static double run(const setting_st *s, int spu, int predelay, bool fast,
+	const sf_sample_st *input, sf_sample_st *output, int size){
+	double best = 1e9;
+	for (int r = 0; r < ROUNDS; r++){
+		sf_compressor_state_st state;
+		init(&state, s, spu, predelay);
+		double t = bench_now();
+		for (int pos = 0; pos < size; pos += CHUNK){
+			int len = size - pos < CHUNK ? size - pos : CHUNK;
+			if (fast)
+				sf_compressor_process_fast(&state, len, (sf_sample_st *)&input[pos], &output[pos]);
+			else
+				sf_compressor_process(&state, len, (sf_sample_st *)&input[pos], &output[pos]);
+		}
+		t = bench_now() - t;
+		if (t < best)
+			best = t;
+		sf_compressor_free(&state);
+	}
+	return best;
+}
+
+// largest difference between the gains behind two outputs, in dB, skipping samples too quiet to
+// give a meaningful ratio
+static double maxgaindiff(const sf_sample_st *a, const sf_sample_st *b, int size){
+	double worst = 0.0;
+	for (int i = 0; i < size; i++){
+		float x = fabsf(a[i].L) > fabsf(a[i].R) ? a[i].L : a[i].R;
+		float y = fabsf(a[i].L) > fabsf(a[i].R) ? b[i].L : b[i].R;
+		if (fabsf(x) < 1e-4f)
+			continue;
+		double d = fabs(20.0 * log10((double)y / x));
+		if (d > worst)
+			worst = d;
+	}
+	return worst;
+}
+
+int main(){
+	int size = RATE * SECONDS;
+	sf_sample_st *input = bench_signal(size, RATE);
+	sf_sample_st *loud = malloc(sizeof(sf_sample_st) * size);
+	sf_sample_st *normal = malloc(sizeof(sf_sample_st) * size);
+	sf_sample_st *fast = malloc(sizeof(sf_sample_st) * size);
+	for (int i = 0; i < size; i++)
+		loud[i] = (sf_sample_st){ .L = input[i].L * 16.0f, .R = input[i].R * 16.0f };
+
+	printf("%ds at %dHz, %d sample calls, best of %d\n", SECONDS, RATE, CHUNK, ROUNDS);
+	printf("  setting    level   SPU   process   process_fast   max gain difference\n");
+	for (int l = 0; l < 2; l++){
+		for (int i = 0; i < (int)(sizeof(settings) / sizeof(settings[0])); i++){
+			for (int j = 0; j < (int)(sizeof(spus) / sizeof(spus[0])); j++){
+				const sf_sample_st *in = l ? loud : input;
+				double tn = run(&settings[i], spus[j], DEFPREDELAY, false, in, normal, size);
+				double tf = run(&settings[i], spus[j], DEFPREDELAY, true, in, fast, size);
+				printf("  %-10s %5s   %3d   %.3fs    %.3fs         %.2e dB\n", settings[i].name,
+					l ? "+24dB" : "0dB", spus[j], tn, tf, maxgaindiff(normal, fast, size));
+			}
+		}
+	}
+
+	printf("\ndefault setting, SPU 32, by predelay\n");
+	printf("  predelay   process   process_fast\n");
+	for (int i = 0; i < (int)(sizeof(predelays) / sizeof(predelays[0])); i++){
+		double tn = run(&settings[0], 32, predelays[i], false, input, normal, size);
+		double tf = run(&settings[0], 32, predelays[i], true, input, fast, size);
+		printf("  %8d   %.3fs    %.3fs\n", predelays[i], tn, tf);
+	}
+
+	free(input);
+	free(loud);
+	free(normal);
+	free(fast);
+	return 0;
+}
@@ -0,0 +1,143 @@
+// (c) Copyright 2016, Sean Connelly (@voidqk), http://syntheti.cc
+// MIT License
+// Project Home: https://github.com/voidqk/sndfilter
+
+// a bank of compressors, against running the same compressors one after another
+//
+// each stream gets its own settings and its own copy of the test signal (shifted in time, and at
+// a different level), and banks of 1 to 16 streams are timed over 20 seconds of stereo, in 128
+// sample calls; a bank runs its streams 8 at a time (in two vectors of four lanes), so the number
+// of lanes that do useful work grows with the bank up to 8, and the time per stream should drop
+// with it
+//
+// the output of every stream should be identical to sf_compressor_process (or _fast), which is
+// checked too
+//
+//   tgt/bench_compressorbank
+
+#include "bench.h"
+#include "../src/compressor.h"
+#include <stdio.h>
+#include <string.h>
+
+#define RATE     44100
+#define SECONDS  20
+#define ROUNDS   5
+#define CHUNK    128
+#define STREAMS  SF_COMPRESSOR_BANK_MAX
+
+static const int banksizes[] = { 1, 2, 3, 4, 8, 16 };
+
+static void init(sf_compressor_state_st *state, int stream){
+	if (!sf_advancecomp(state, RATE, 0.0f, -24.0f - stream, 30.0f - stream, 12.0f - stream * 0.5f,
+		0.003f, 0.250f, 0.006f, 0.09f, 0.16f, 0.42f, 0.98f, 0.0f, 1.0f, 32)){
+		printf("out of memory\n");
+		exit(1);
+	}
+}
+
+// process the first `streams` streams one after another, returning the best time of ROUNDS
+static double alone(int streams, bool fast, sf_sample_st **input, sf_sample_st **output,
+	int size){
+	double best = 1e9;
+	for (int r = 0; r < ROUNDS; r++){
+		sf_compressor_state_st state[STREAMS];
+		for (int i = 0; i < streams; i++)
+			init(&state[i], i);
+		double t = bench_now();
+		for (int pos = 0; pos < size; pos += CHUNK){
+			int len = size - pos < CHUNK ? size - pos : CHUNK;
+			for (int i = 0; i < streams; i++){
+				if (fast)
+					sf_compressor_process_fast(&state[i], len, &input[i][pos], &output[i][pos]);
+				else
+					sf_compressor_process(&state[i], len, &input[i][pos], &output[i][pos]);
+			}
+		}
+		t = bench_now() - t;
+		if (t < best)
+			best = t;
+		for (int i = 0; i < streams; i++)
+			sf_compressor_free(&state[i]);
+	}
+	return best;
+}
+
+// same, with the streams in one bank
+static double banked(int streams, bool fast, sf_sample_st **input, sf_sample_st **output,
+	int size){
+	double best = 1e9;
+	for (int r = 0; r < ROUNDS; r++){
+		sf_compressor_state_st state[STREAMS];
+		sf_compressor_bank_st bank;
+		sf_compressor_bank_init(&bank, streams);
+		for (int i = 0; i < streams; i++){
+			init(&state[i], i);
+			sf_compressor_bank_set(&bank, i, &state[i]);
+		}
+		sf_sample_st *in[STREAMS], *out[STREAMS];
+		double t = bench_now();
+		for (int pos = 0; pos < size; pos += CHUNK){
+			int len = size - pos < CHUNK ? size - pos : CHUNK;
+			for (int i = 0; i < streams; i++){
+				in[i] = &input[i][pos];
+				out[i] = &output[i][pos];
+			}
+			if (fast)
+				sf_compressor_bank_process_fast(&bank, len, in, out);
+			else
+				sf_compressor_bank_process(&bank, len, in, out);
+		}
+		t = bench_now() - t;
+		if (t < best)
+			best = t;
+		for (int i = 0; i < streams; i++)
+			sf_compressor_free(&state[i]);
+	}
+	return best;
+}
+
+int main(){
+	int size = RATE * SECONDS;
+	sf_sample_st *signal = bench_signal(size + RATE, RATE);
+	sf_sample_st *input[STREAMS], *alonebuf[STREAMS], *bankbuf[STREAMS];
+	for (int i = 0; i < STREAMS; i++){
+		input[i] = malloc(sizeof(sf_sample_st) * size);
+		alonebuf[i] = malloc(sizeof(sf_sample_st) * size);
+		bankbuf[i] = malloc(sizeof(sf_sample_st) * size);
+		float level = 0.5f + 0.25f * i;
+		for (int n = 0; n < size; n++){
+			sf_sample_st s = signal[n + i * RATE / STREAMS];
+			input[i][n] = (sf_sample_st){ .L = s.L * level, .R = s.R * level };
+		}
+	}
+
+	printf("%ds at %dHz per stream, %d sample calls, best of %d\n", SECONDS, RATE, CHUNK, ROUNDS);
+	printf("time per stream:\n");
+	printf("                     process                  process_fast\n");
+	printf("  streams   alone     bank     speedup   alone     bank     speedup   output\n");
+	for (int b = 0; b < (int)(sizeof(banksizes) / sizeof(banksizes[0])); b++){
+		int streams = banksizes[b];
+		double t[2][2];
+		bool same = true;
+		for (int f = 0; f < 2; f++){
+			t[f][0] = alone(streams, f, input, alonebuf, size) / streams;
+			t[f][1] = banked(streams, f, input, bankbuf, size) / streams;
+			for (int i = 0; i < streams; i++){
+				if (memcmp(alonebuf[i], bankbuf[i], sizeof(sf_sample_st) * size) != 0)
+					same = false;
+			}
+		}
+		printf("  %7d   %.3fs   %.3fs   %.2fx     %.3fs   %.3fs   %.2fx     %s\n", streams,
+			t[0][0], t[0][1], t[0][0] / t[0][1], t[1][0], t[1][1], t[1][0] / t[1][1],
+			same ? "identical" : "DIFFERENT");
+	}
+
+	free(signal);
+	for (int i = 0; i < STREAMS; i++){
+		free(input[i]);
+		free(alonebuf[i]);
+		free(bankbuf[i]);
+	}
+	return 0;
+}
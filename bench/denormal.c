@@ -0,0 +1,79 @@
+// (c) Copyright 2016, Sean Connelly (@voidqk), http://syntheti.cc
+// MIT License
+// Project Home: https://github.com/voidqk/sndfilter
+
+// cost of filter and reverb tails that decay into silence
+//
+// an impulse is followed by silence, and processed in 4096 sample chunks; without flushing
+// denormals to zero, the time per chunk climbs once the feedback loops decay into denormal range
+//
+// build with bench/build, which also makes bench_denormal_noftz with SF_NO_FTZ defined, then
+// compare the two:
+//
+//   tgt/bench_denormal [seconds of silence]
+//   tgt/bench_denormal_noftz [seconds of silence]
+
+#include "bench.h"
+#include "../src/biquad.h"
+#include "../src/reverb.h"
+#include <stdio.h>
+#include <string.h>
+
+#define RATE   44100
+#define CHUNK  4096
+
+static sf_biquad_state_st lowpass[16];
+static sf_reverb_state_st reverb;
+
+static void run_lowpass(sf_sample_st *buf, int size){
+	for (int i = 0; i < 16; i++)
+		sf_biquad_process(&lowpass[i], size, buf, buf);
+}
+
+static void run_reverb(sf_sample_st *buf, int size){
+	sf_reverb_process(&reverb, size, buf, buf);
+}
+
+// run an impulse and `seconds` of silence through `run`, and report the time of the first second
+// next to the slowest second of the tail
+static void measure(const char *name, void (*run)(sf_sample_st *, int), int seconds){
+	int size = RATE * (seconds + 1);
+	sf_sample_st *buf = malloc(sizeof(sf_sample_st) * size);
+	memset(buf, 0, sizeof(sf_sample_st) * size);
+	buf[0] = (sf_sample_st){ .L = 1.0f, .R = 1.0f };
+	double first = 0.0, slowest = 0.0, total = 0.0, secondtime = 0.0;
+	int secondpos = 0;
+	for (int pos = 0; pos < size; pos += CHUNK){
+		int len = size - pos < CHUNK ? size - pos : CHUNK;
+		double t = bench_now();
+		run(&buf[pos], len);
+		t = bench_now() - t;
+		total += t;
+		secondtime += t;
+		secondpos += len;
+		if (secondpos >= RATE || pos + len >= size){
+			if (first == 0.0)
+				first = secondtime;
+			else if (secondtime > slowest)
+				slowest = secondtime;
+			secondtime = 0.0;
+			secondpos = 0;
+		}
+	}
+	printf("%-12s total %7.3fs   first second %6.2fms   slowest second of the tail %6.2fms\n",
+		name, total, first * 1000.0, slowest * 1000.0);
+	free(buf);
+}
+
+int main(int argc, char **argv){
+	int seconds = argc > 1 ? atoi(argv[1]) : 30;
+	if (seconds < 1)
+		seconds = 1;
+	printf("impulse + %ds of silence at %dHz, %d sample chunks\n", seconds, RATE, CHUNK);
+	for (int i = 0; i < 16; i++)
+		sf_lowpass(&lowpass[i], RATE, 1000, 1);
+	measure("lowpass x16", run_lowpass, seconds);
+	sf_presetreverb(&reverb, RATE, SF_REVERB_PRESET_DEFAULT);
+	measure("reverb", run_reverb, seconds);
+	return 0;
+}
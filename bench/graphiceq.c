@@ -0,0 +1,103 @@
+// (c) Copyright 2016, Sean Connelly (@voidqk), http://syntheti.cc
+// MIT License
+// Project Home: https://github.com/voidqk/sndfilter
+
+// the graphic equalizer, against the straightforward way of doing the same thing: one sf_peaking
+// filter per band, each run as its own sf_biquad_process pass
+//
+// measures processing 60 seconds of stereo with all 31 bands set, and with only 11 of them set
+// (the graphic EQ skips bands at 0dB), and the time to redesign all of the bands
+//
+//   tgt/bench_graphiceq
+
+#include "bench.h"
+#include "../src/graphiceq.h"
+#include <stdio.h>
+#include <string.h>
+
+#define RATE     44100
+#define SECONDS  60
+#define ROUNDS   5
+#define DESIGNS  100000
+
+// the value to give sf_peaking for each band (it puts the peak at twice the frequency it is given)
+static float peakingfreq[SF_GRAPHICEQ_BANDS];
+
+// process the sound with one sf_peaking pass per band, the way it'd be done without the graphic EQ
+static double peakingpasses(const sf_sample_st *input, sf_sample_st *output, int size,
+	const float *gains){
+	double best = 1e9;
+	for (int r = 0; r < ROUNDS; r++){
+		double t = bench_now();
+		memcpy(output, input, sizeof(sf_sample_st) * size);
+		for (int b = 0; b < SF_GRAPHICEQ_BANDS; b++){
+			sf_biquad_state_st s;
+			sf_peaking(&s, RATE, peakingfreq[b], SF_GRAPHICEQ_Q, gains[b]);
+			sf_biquad_process(&s, size, output, output);
+		}
+		t = bench_now() - t;
+		if (t < best)
+			best = t;
+	}
+	return best;
+}
+
+static double graphiceq(const sf_sample_st *input, sf_sample_st *output, int size,
+	const float *gains){
+	double best = 1e9;
+	for (int r = 0; r < ROUNDS; r++){
+		sf_graphiceq_st eq;
+		sf_graphiceq_init(&eq, RATE, SF_GRAPHICEQ_Q);
+		double t = bench_now();
+		sf_graphiceq_set(&eq, gains);
+		sf_graphiceq_process(&eq, size, (sf_sample_st *)input, output);
+		t = bench_now() - t;
+		if (t < best)
+			best = t;
+	}
+	return best;
+}
+
+int main(){
+	int size = RATE * SECONDS;
+	sf_sample_st *input = bench_signal(size, RATE);
+	sf_sample_st *output = malloc(sizeof(sf_sample_st) * size);
+
+	float all[SF_GRAPHICEQ_BANDS], some[SF_GRAPHICEQ_BANDS];
+	for (int b = 0; b < SF_GRAPHICEQ_BANDS; b++){
+		peakingfreq[b] = 1000.0f * powf(2.0f, (b - 17) / 3.0f) * 0.5f;
+		all[b] = b % 2 ? -3.0f : 4.0f;
+		some[b] = b % 3 == 0 ? all[b] : 0.0f; // 11 bands
+	}
+
+	printf("%ds at %dHz, best of %d\n", SECONDS, RATE, ROUNDS);
+	printf("  all 31 bands    graphic EQ %.3fs   31 x sf_peaking passes %.3fs\n",
+		graphiceq(input, output, size, all), peakingpasses(input, output, size, all));
+	printf("  11 bands set    graphic EQ %.3fs   31 x sf_peaking passes %.3fs\n",
+		graphiceq(input, output, size, some), peakingpasses(input, output, size, some));
+
+	// redesigning every band, which happens whenever a slider moves
+	sf_graphiceq_st eq;
+	sf_graphiceq_init(&eq, RATE, SF_GRAPHICEQ_Q);
+	float gains[SF_GRAPHICEQ_BANDS];
+	memcpy(gains, all, sizeof(gains));
+	double t = bench_now();
+	for (int i = 0; i < DESIGNS; i++){
+		gains[i % SF_GRAPHICEQ_BANDS] += 0.001f; // so nothing can be skipped
+		sf_graphiceq_set(&eq, gains);
+	}
+	double tset = (bench_now() - t) / DESIGNS;
+	static sf_biquad_state_st bands[SF_GRAPHICEQ_BANDS];
+	t = bench_now();
+	for (int i = 0; i < DESIGNS; i++){
+		gains[i % SF_GRAPHICEQ_BANDS] += 0.001f;
+		for (int b = 0; b < SF_GRAPHICEQ_BANDS; b++)
+			sf_peaking(&bands[b], RATE, peakingfreq[b], SF_GRAPHICEQ_Q, gains[b]);
+	}
+	double tpeaking = (bench_now() - t) / DESIGNS;
+	printf("  redesign all    sf_graphiceq_set %.2fus   31 x sf_peaking %.2fus\n", tset * 1e6,
+		tpeaking * 1e6);
+	free(input);
+	free(output);
+	return 0;
+}
@@ -0,0 +1,117 @@
+// (c) Copyright 2016, Sean Connelly (@voidqk), http://syntheti.cc
+// MIT License
+// Project Home: https://github.com/voidqk/sndfilter
+
+// sf_limiter_process against a naive version of the same limiter, which finds the smallest gain of
+// the look-ahead by scanning the whole window for every sample
+//
+// the window minimum queue has to hold one more gain than the window for a moment, and windows
+// that are exactly a power of 2 are the ones that used to run out of room, so the look-aheads are
+// picked on both sides of a few powers of 2; the test signal is made 12dB louder so the limiter
+// works hard, and starts each second with a ramp falling from +12dB to 0dB, which keeps every gain
+// of the window in the queue; the output of both versions should be identical
+//
+//   tgt/bench_limiter
+
+#include "bench.h"
+#include "../src/limiter.h"
+#include <stdio.h>
+#include <string.h>
+
+#define RATE     44100
+#define SECONDS  10
+#define CHUNK    128
+#define CEILING  -1.0f
+#define RELEASE  0.05f
+#define RAMP     8192
+
+static const int windows[] = { 1, 2, 3, 4, 63, 64, 65, 100, 128, 255, 256, 1000, 1024, 4096 };
+
+// the same steps as sf_limiter_process (without true peak), using the limiter's own coefficients so
+// the math rounds the same way, with the smallest gain found by brute force
+static void naive(const sf_limiter_st *lim, int size, const sf_sample_st *input,
+	sf_sample_st *output){
+	int window = lim->window;
+	// everything is indexed by sample, with `window` samples of silence in front
+	float *targets = malloc(sizeof(float) * (size + window));
+	float *mins = malloc(sizeof(float) * (size + window));
+	for (int i = 0; i < window; i++){
+		targets[i] = 1.0f;
+		mins[i] = 1.0f;
+	}
+	double windowsum = window;
+	float gain = 1.0f;
+	for (int n = 0; n < size; n++){
+		int t = n + window;
+		float peak = fmaxf(fabsf(input[n].L), fabsf(input[n].R));
+		targets[t] = peak > lim->ceiling ? lim->ceiling / peak : 1.0f;
+		float windowmin = targets[t];
+		for (int i = 1; i < window; i++){
+			if (targets[t - i] < windowmin)
+				windowmin = targets[t - i];
+		}
+		windowsum += windowmin - mins[t - window];
+		mins[t] = windowmin;
+		float smoothgain = windowsum * lim->windowinv;
+		if (smoothgain < gain)
+			gain = smoothgain;
+		else
+			gain += (smoothgain - gain) * lim->releasecoef;
+		// the sample coming out of the delay, window - 1 samples ago
+		int d = n - (window - 1);
+		if (gain > targets[t - (window - 1)])
+			gain = targets[t - (window - 1)];
+		sf_sample_st in = d >= 0 ? input[d] : (sf_sample_st){ .L = 0.0f, .R = 0.0f };
+		output[n] = (sf_sample_st){ .L = in.L * gain, .R = in.R * gain };
+	}
+	free(targets);
+	free(mins);
+}
+
+int main(){
+	int size = RATE * SECONDS;
+	sf_sample_st *input = bench_signal(size, RATE);
+	sf_sample_st *limited = malloc(sizeof(sf_sample_st) * size);
+	sf_sample_st *reference = malloc(sizeof(sf_sample_st) * size);
+	for (int i = 0; i < size; i++){
+		int r = i % RATE;
+		if (r < RAMP){
+			float v = 4.0f - 3.0f * r / RAMP;
+			input[i] = (sf_sample_st){ .L = v, .R = -v };
+		}
+		else
+			input[i] = (sf_sample_st){ .L = input[i].L * 4.0f, .R = input[i].R * 4.0f };
+	}
+
+	printf("%ds at %dHz, %d sample calls\n", SECONDS, RATE, CHUNK);
+	printf("  window   limiter   naive     output\n");
+	int failed = 0;
+	for (int w = 0; w < (int)(sizeof(windows) / sizeof(windows[0])); w++){
+		// the look-ahead is nudged by half a sample so it doesn't round down
+		sf_limiter_st lim;
+		if (!sf_limiter_init(&lim, RATE, CEILING, (windows[w] + 0.5f) / RATE, RELEASE, false)){
+			printf("out of memory\n");
+			return 1;
+		}
+		double tn = bench_now();
+		naive(&lim, size, input, reference);
+		tn = bench_now() - tn;
+		double tl = bench_now();
+		for (int pos = 0; pos < size; pos += CHUNK){
+			int len = size - pos < CHUNK ? size - pos : CHUNK;
+			sf_limiter_process(&lim, len, &input[pos], &limited[pos]);
+		}
+		tl = bench_now() - tl;
+		bool same = lim.window == windows[w] &&
+			memcmp(limited, reference, sizeof(sf_sample_st) * size) == 0;
+		if (!same)
+			failed++;
+		printf("  %6d   %.3fs    %.3fs    %s\n", windows[w], tl, tn, same ? "identical" :
+			"DIFFERENT");
+		sf_limiter_free(&lim);
+	}
+	free(input);
+	free(limited);
+	free(reference);
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,199 @@
+// (c) Copyright 2016, Sean Connelly (@voidqk), http://syntheti.cc
+// MIT License
+// Project Home: https://github.com/voidqk/sndfilter
+
+#include "analyzer.h"
+#include "simd.h"
+#include "denormal.h"
+#include <math.h>
+#include <string.h>
+
+// stage s runs at rate / 2^s, and a band is placed in the lowest stage where its upper edge is
+// still below 20% of that stage's sample rate
+//
+// before each decimation, an 8th order Butterworth lowpass at 15% of the sample rate (30% of the
+// rate after decimating) removes what would fold back down into the bands of the next stage; it's
+// flat to within 0.01dB over the bands of the stages below, and anything that would land on top of
+// them after decimating is at least 68dB down
+#define ANALYZER_BANDEDGE  0.2
+#define ANALYZER_CUTOFF    0.15
+
+// number of samples each stage works on at once
+#define ANALYZER_BLOCK     256
+
+bool sf_analyzer_init(sf_analyzer_st *an, int rate, int fraction, int hop){
+	if (rate <= 0 || fraction < 1 || fraction > 6 || hop < 1)
+		return false;
+	memset(an, 0, sizeof(sf_analyzer_st));
+	an->hop = hop;
+
+	// pick out the bands between 20Hz and 20kHz that are centered below the nyquist frequency
+	double halfband = pow(2.0, 0.5 / fraction); // from the center of a band to its upper edge
+	int stage[SF_ANALYZER_MAX];
+	int kmin = (int)lround(fraction * log2(20.0 / 1000.0));
+	int kmax = (int)lround(fraction * log2(20000.0 / 1000.0));
+	for (int k = kmin; k <= kmax; k++){
+		double f = 1000.0 * pow(2.0, (double)k / fraction);
+		if (f >= rate * 0.5)
+			break;
+		if (an->size >= SF_ANALYZER_MAX)
+			return false;
+		int s = 0;
+		while (s + 1 < SF_ANALYZER_STAGES &&
+			f * halfband <= ANALYZER_BANDEDGE * rate / (double)(1 << (s + 1)))
+			s++;
+		if (s + 1 > an->stages)
+			an->stages = s + 1;
+		stage[an->size] = s;
+		an->freqs[an->size] = (float)f;
+		an->level[an->size] = -200.0f;
+		an->size++;
+	}
+	if (an->size <= 0)
+		return false;
+
+	// lay out the lanes, stage by stage
+	int lane = 0;
+	for (int s = 0; s < an->stages; s++){
+		an->first[s] = lane;
+		double srate = rate / (double)(1 << s);
+		for (int i = 0; i < an->size; i++){
+			if (stage[i] != s)
+				continue;
+			// bandpass with a peak gain of 0dB, one band wide (RBJ cookbook, in double precision)
+			double w0 = 2.0 * M_PI * an->freqs[i] / srate;
+			double sn = sin(w0);
+			double alpha = sn * sinh(M_LN2 * 0.5 / fraction * w0 / sn);
+			double a0 = 1.0 + alpha;
+			an->b0[lane] = (float)(alpha / a0);
+			an->b2[lane] = (float)(-alpha / a0);
+			an->a1[lane] = (float)(-2.0 * cos(w0) / a0);
+			an->a2[lane] = (float)((1.0 - alpha) / a0);
+			an->lane[i] = lane;
+			lane++;
+		}
+		// pad the stage up to a multiple of 4 lanes, which stay silent
+		lane = (lane + 3) & ~3;
+		if (s + 1 < an->stages){
+			sf_biquad_chain_init(&an->decimate[s]);
+			// the design only depends on the cutoff relative to the sample rate, which is the same
+			// for every stage (and the rate of a stage isn't always a whole number)
+			sf_butterworth(&an->decimate[s], SF_BIQUAD_LOWPASS, 8, 1000000,
+				(float)(1000000 * ANALYZER_CUTOFF));
+		}
+	}
+	an->first[an->stages] = lane;
+	return true;
+}
+
+// run the bandpass filters of four lanes over a block, and add up the squared output
+//
+// every lane is an independent filter fed with the same sound, so the feedback chains of the bands
+// overlap instead of waiting on each other (like sf_biquad_bank_process)
+static void analyzer_group(sf_analyzer_st *an, int lane, int size, const sf_sample_st *input){
+	vec4 b0 = vec4_load(&an->b0[lane]);
+	vec4 b2 = vec4_load(&an->b2[lane]);
+	vec4 a1 = vec4_load(&an->a1[lane]);
+	vec4 a2 = vec4_load(&an->a2[lane]);
+	vec4 xn1L = vec4_load(&an->xn1L[lane]), xn1R = vec4_load(&an->xn1R[lane]);
+	vec4 xn2L = vec4_load(&an->xn2L[lane]), xn2R = vec4_load(&an->xn2R[lane]);
+	vec4 yn1L = vec4_load(&an->yn1L[lane]), yn1R = vec4_load(&an->yn1R[lane]);
+	vec4 yn2L = vec4_load(&an->yn2L[lane]), yn2R = vec4_load(&an->yn2R[lane]);
+	vec4 sum = vec4_set1(0.0f);
+
+	for (int n = 0; n < size; n++){
+		vec4 xn0L = vec4_set1(input[n].L);
+		vec4 xn0R = vec4_set1(input[n].R);
+
+		// b1 is always 0 for a bandpass, so that term is left out
+		vec4 yn0L = vec4_sub(vec4_sub(vec4_add(
+			vec4_mul(b0, xn0L), vec4_mul(b2, xn2L)),
+			vec4_mul(a1, yn1L)), vec4_mul(a2, yn2L));
+		vec4 yn0R = vec4_sub(vec4_sub(vec4_add(
+			vec4_mul(b0, xn0R), vec4_mul(b2, xn2R)),
+			vec4_mul(a1, yn1R)), vec4_mul(a2, yn2R));
+		sum = vec4_add(sum, vec4_add(vec4_mul(yn0L, yn0L), vec4_mul(yn0R, yn0R)));
+
+		// slide everything down one sample
+		xn2L = xn1L; xn2R = xn1R;
+		xn1L = xn0L; xn1R = xn0R;
+		yn2L = yn1L; yn2R = yn1R;
+		yn1L = yn0L; yn1R = yn0R;
+	}
+
+	// save the state for future processing
+	vec4_store(&an->xn1L[lane], xn1L); vec4_store(&an->xn1R[lane], xn1R);
+	vec4_store(&an->xn2L[lane], xn2L); vec4_store(&an->xn2R[lane], xn2R);
+	vec4_store(&an->yn1L[lane], yn1L); vec4_store(&an->yn1R[lane], yn1R);
+	vec4_store(&an->yn2L[lane], yn2L); vec4_store(&an->yn2R[lane], yn2R);
+	// the block's sum is small enough for float, but the whole frame is added up in double
+	for (int i = 0; i < 4; i++)
+		an->energy[lane + i] += vec4_get(sum, i);
+}
+
+// run every stage over one block of the input
+static void analyzer_block(sf_analyzer_st *an, int size, sf_sample_st *input){
+	sf_sample_st scratch[ANALYZER_BLOCK];
+	sf_sample_st *cur = input;
+	for (int s = 0; s < an->stages && size > 0; s++){
+		for (int lane = an->first[s]; lane < an->first[s + 1]; lane += 4)
+			analyzer_group(an, lane, size, cur);
+		an->count[s] += size;
+		if (s + 1 >= an->stages)
+			break;
+
+		// lowpass the block and keep every other sample for the next stage
+		sf_biquad_chain_process(&an->decimate[s], size, cur, scratch);
+		int m = 0;
+		for (int n = 0; n < size; n++){
+			if (an->phase[s] == 0)
+				scratch[m++] = scratch[n];
+			an->phase[s] ^= 1;
+		}
+		cur = scratch;
+		size = m;
+	}
+}
+
+// convert the energy of each band into a level, and start a new frame
+static void analyzer_frame(sf_analyzer_st *an, float *levels){
+	for (int i = 0; i < an->size; i++){
+		int lane = an->lane[i];
+		int s = 0;
+		while (lane >= an->first[s + 1])
+			s++;
+		// a hop shorter than the decimation of a stage can end before the stage sees a sample, in
+		// which case the band keeps its last level
+		if (an->count[s] > 0)
+			an->level[i] = 10.0f * log10f((float)(an->energy[lane] / (2.0 * an->count[s])) + 1e-20f);
+		levels[i] = an->level[i];
+	}
+	for (int i = 0; i < an->first[an->stages]; i++)
+		an->energy[i] = 0.0;
+	for (int s = 0; s < an->stages; s++)
+		an->count[s] = 0;
+}
+
+int sf_analyzer_process(sf_analyzer_st *an, int size, sf_sample_st *input, float *levels){
+	uint64_t ftz = ftz_begin();
+	int frames = 0;
+	while (size > 0){
+		// stop each block at the end of the frame
+		int len = an->hop - an->pos;
+		if (len > size)
+			len = size;
+		if (len > ANALYZER_BLOCK)
+			len = ANALYZER_BLOCK;
+		analyzer_block(an, len, input);
+		input += len;
+		size -= len;
+		an->pos += len;
+		if (an->pos >= an->hop){
+			analyzer_frame(an, &levels[frames * an->size]);
+			frames++;
+			an->pos = 0;
+		}
+	}
+	ftz_end(ftz);
+	return frames;
+}
@@ -0,0 +1,95 @@
+// (c) Copyright 2016, Sean Connelly (@voidqk), http://syntheti.cc
+// MIT License
+// Project Home: https://github.com/voidqk/sndfilter
+
+// octave and fractional octave band analyzer
+
+#ifndef SNDFILTER_ANALYZER__H
+#define SNDFILTER_ANALYZER__H
+
+#include "snd.h"
+#include "biquad.h"
+
+// the analyzer measures how loud a sound is in each band of frequencies, for example, the 31
+// third-octave bands from 20Hz to 20kHz, by running a bandpass filter for each band and measuring
+// the RMS level of what comes out
+//
+// the bands are centered at exactly 1000 * 2^(k / fraction) Hz, so a `fraction` of 1 gives octave
+// bands (nominally 16Hz, 31.5Hz, 63Hz, ... 16kHz, actually 15.6Hz, 31.25Hz, 62.5Hz, ...), and a
+// `fraction` of 3 gives third-octave bands (nominally 20Hz, 25Hz, 31.5Hz, ... 20kHz, actually
+// 19.69Hz, 24.8Hz, 31.25Hz, ... 20.16kHz), where each bandpass is one band wide; bands centered at
+// or above the nyquist frequency are left out
+//
+// instead of running every bandpass over the whole sound, the analyzer splits the bands into
+// stages: the highest bands run at the full sample rate, and each stage below that runs on a copy
+// of the sound that is lowpassed and decimated by another factor of 2, since the low bands don't
+// need all of those samples -- so all of the low bands together cost less than one of the high
+// bands
+//
+// inside a stage, the bandpass filters run four bands at a time, one per vector lane, and the
+// squared output is added up directly, so the filtered sound is never stored
+//
+// the levels come out once every `hop` samples, as the RMS level (in dB) of both channels over the
+// last hop, so a full scale sine wave in both channels measures -3dB in its band
+//
+// the lowpass filters in front of the decimated stages delay the sound a little, so the lowest
+// bands lag behind the highest ones (by around 60ms for 20Hz at 44100Hz), which only matters for
+// very short hops
+//
+// for example, to measure third-octave levels every 100ms of a 44100Hz stream:
+//
+//   sf_analyzer_st an;
+//   sf_analyzer_init(&an, 44100, 3, 4410);
+//   float *levels = malloc(sizeof(float) * an.size * (128 / 4410 + 1));
+//
+//   for each 128 length sample:
+//     int frames = sf_analyzer_process(&an, 128, input, levels);
+//     // levels[f * an.size + i] is the level of band i (an.freqs[i] Hz) for frame f
+//
+// the band frequencies are the actual frequencies in the sound, unlike sf_bandpass which places
+// its frequency at twice the value given (see sf_biquad_response)
+
+// maximum number of bands
+#define SF_ANALYZER_MAX     64
+
+// maximum number of decimated stages
+#define SF_ANALYZER_STAGES  12
+
+// each stage pads its bands up to a multiple of 4 lanes
+#define SF_ANALYZER_LANES   (SF_ANALYZER_MAX + 4 * SF_ANALYZER_STAGES)
+
+typedef struct {
+	int size;                         // number of bands
+	int hop;                          // samples per frame of levels
+	int pos;                          // samples so far in the current frame
+	int stages;                       // number of stages in use
+	float freqs[SF_ANALYZER_MAX];     // center frequency of each band (Hz)
+	float level[SF_ANALYZER_MAX];     // level of each band from the last frame (dB)
+	int lane[SF_ANALYZER_MAX];        // which lane each band uses
+	int first[SF_ANALYZER_STAGES + 1]; // first lane of each stage
+	int count[SF_ANALYZER_STAGES];    // samples each stage has seen in the current frame
+	int phase[SF_ANALYZER_STAGES];    // which sample the decimation after each stage keeps next
+	sf_biquad_chain_st decimate[SF_ANALYZER_STAGES]; // lowpass before each decimation
+	// bandpass filter of each lane
+	float b0[SF_ANALYZER_LANES];
+	float b2[SF_ANALYZER_LANES]; // b1 is always 0
+	float a1[SF_ANALYZER_LANES];
+	float a2[SF_ANALYZER_LANES];
+	float xn1L[SF_ANALYZER_LANES], xn1R[SF_ANALYZER_LANES];
+	float xn2L[SF_ANALYZER_LANES], xn2R[SF_ANALYZER_LANES];
+	float yn1L[SF_ANALYZER_LANES], yn1R[SF_ANALYZER_LANES];
+	float yn2L[SF_ANALYZER_LANES], yn2R[SF_ANALYZER_LANES];
+	double energy[SF_ANALYZER_LANES]; // sum of the squared output in the current frame
+} sf_analyzer_st;
+
+// initialize an analyzer for 1/fraction octave bands between 20Hz and 20kHz, which produces a
+// frame of levels every `hop` samples
+// returns false if the settings aren't supported (`fraction` can be 1 to 6)
+bool sf_analyzer_init(sf_analyzer_st *an, int rate, int fraction, int hop);
+
+// analyze `size` samples of the input, and write a frame of an.size levels to `levels` every time
+// a hop is completed -- so `levels` needs room for (size / hop + 1) frames
+// returns the number of frames written
+int sf_analyzer_process(sf_analyzer_st *an, int size, sf_sample_st *input, float *levels);
+
+#endif // SNDFILTER_ANALYZER__H
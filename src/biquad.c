@@ -3,7 +3,29 @@
 // Project Home: https://github.com/voidqk/sndfilter
 
 #include "biquad.h"
+#include "simd.h"
+#include "fastmath.h"
+#include "denormal.h"
+#include "mem.h"
 #include <math.h>
+#include <string.h>
+
+// the parallel processing uses pthreads, which come with POSIX systems (Linux, macOS, the BSDs,
+// etc); on every other system, or if SF_NO_THREADS is defined, the parallel functions process the
+// sound serially on the calling thread instead
+#if defined(SF_NO_THREADS)
+#	define SF_THREADS 0
+#elif defined(__unix__) || defined(__APPLE__)
+#	include <unistd.h>
+#	if defined(_POSIX_THREADS) && _POSIX_THREADS > 0
+#		define SF_THREADS 1
+#		include <pthread.h>
+#	else
+#		define SF_THREADS 0
+#	endif
+#else
+#	define SF_THREADS 0
+#endif
 
 // biquad filtering is based on a small sliding window, where the different filters are a result of
 // simply changing the coefficients used while processing the samples
@@ -12,9 +34,57 @@
 //   b0, b1, b2, a1, a2      transformation coefficients
 //   xn0, xn1, xn2           the unfiltered sample at position x[n], x[n-1], and x[n-2]
 //   yn1, yn2                the filtered sample at position y[n-1] and y[n-2]
-void sf_biquad_process(sf_biquad_state_st *state, int size, sf_sample_st *input,
-	sf_sample_st *output){
+//
+// when SIMD is available, the L and R channels are run together in the lanes of one vector; the
+// formula and the order of operations is exactly the same as the scalar version, so the results
+// match the scalar loop bit-for-bit, unless the compiler decides to fuse the multiply and adds into
+// FMA instructions, in which case each sample stays within 1e-6 (relative) of the scalar result
+//
+// the samples are read from input[0], input[step], input[2 * step], etc, so that the offline
+// functions can also run the filter backwards over a sound (step = -1) without copying it
+static inline void biquad_run(sf_biquad_state_st *state, int size, sf_sample_st *input,
+	sf_sample_st *output, int step){
+#if SF_SIMD
+	// pull out the state into vector registers
+	vec4 b0 = vec4_set1(state->b0);
+	vec4 b1 = vec4_set1(state->b1);
+	vec4 b2 = vec4_set1(state->b2);
+	vec4 a1 = vec4_set1(state->a1);
+	vec4 a2 = vec4_set1(state->a2);
+	vec4 xn1 = vec4_fromsample(state->xn1);
+	vec4 xn2 = vec4_fromsample(state->xn2);
+	vec4 yn1 = vec4_fromsample(state->yn1);
+	vec4 yn2 = vec4_fromsample(state->yn2);
+
+	// loop for each sample
+	for (int n = 0; n < size; n++){
+		// get the current sample in both lanes
+		vec4 xn0 = vec4_fromsample(input[n * step]);
+
+		// the formula is the same as the scalar version, for both channels at once
+		vec4 yn0 = vec4_sub(vec4_sub(vec4_add(vec4_add(
+			vec4_mul(b0, xn0),
+			vec4_mul(b1, xn1)),
+			vec4_mul(b2, xn2)),
+			vec4_mul(a1, yn1)),
+			vec4_mul(a2, yn2));
 
+		// save the result
+		output[n * step] = vec4_tosample(yn0);
+
+		// slide everything down one sample
+		xn2 = xn1;
+		xn1 = xn0;
+		yn2 = yn1;
+		yn1 = yn0;
+	}
+
+	// save the state for future processing
+	state->xn1 = vec4_tosample(xn1);
+	state->xn2 = vec4_tosample(xn2);
+	state->yn1 = vec4_tosample(yn1);
+	state->yn2 = vec4_tosample(yn2);
+#else
 	// pull out the state into local variables
 	float b0 = state->b0;
 	float b1 = state->b1;
@@ -29,7 +99,7 @@ void sf_biquad_process(sf_biquad_state_st *state, int size, sf_sample_st *input,
 	// loop for each sample
 	for (int n = 0; n < size; n++){
 		// get the current sample
-		sf_sample_st xn0 = input[n];
+		sf_sample_st xn0 = input[n * step];
 
 		// the formula is the same for each channel
 		float L =
@@ -46,13 +116,13 @@ void sf_biquad_process(sf_biquad_state_st *state, int size, sf_sample_st *input,
 			a2 * yn2.R;
 
 		// save the result
-		output[n] = (sf_sample_st){ L, R };
+		output[n * step] = (sf_sample_st){ L, R };
 
 		// slide everything down one sample
 		xn2 = xn1;
 		xn1 = xn0;
 		yn2 = yn1;
-		yn1 = output[n];
+		yn1 = output[n * step];
 	}
 
 	// save the state for future processing
@@ -60,6 +130,901 @@ void sf_biquad_process(sf_biquad_state_st *state, int size, sf_sample_st *input,
 	state->xn2 = xn2;
 	state->yn1 = yn1;
 	state->yn2 = yn2;
+#endif
+}
+
+void sf_biquad_process(sf_biquad_state_st *state, int size, sf_sample_st *input,
+	sf_sample_st *output){
+	uint64_t ftz = ftz_begin();
+	biquad_run(state, size, input, output, 1);
+	ftz_end(ftz);
+}
+
+// the block version works by splitting the biquad into two parts:
+//
+//   v[n] = b0 * x[n] + b1 * x[n-1] + b2 * x[n-2]     (feedforward)
+//   y[n] = v[n] - a1 * y[n-1] - a2 * y[n-2]          (feedback)
+//
+// unrolling the feedback over 4 samples, each output in the block ends up being a weighted sum of
+// the inputs x[n-2] .. x[n+3], plus a weighted sum of the two outputs from before the block:
+//
+//   y[n+i] = sum(gj[i] * x[n+j], for j = -2 .. 3) + c1[i] * y[n-1] + c2[i] * y[n-2]
+//
+// the weights only depend on the coefficients, so they are calculated once up front, and then
+// every block of 4 outputs is a handful of vector multiply-adds, where only the y[n-1] and y[n-2]
+// terms depend on the previous block
+//
+// the vectors hold two stereo samples each (L0, R0, L1, R1), matching the layout in memory, so a
+// block is two vectors: one for outputs 0-1, and one for outputs 2-3
+void sf_biquad_process_block(sf_biquad_state_st *state, int size, sf_sample_st *input,
+	sf_sample_st *output){
+	uint64_t ftz = ftz_begin();
+	float b[3] = { state->b0, state->b1, state->b2 };
+	float a1 = state->a1;
+	float a2 = state->a2;
+
+	// h is the impulse response of the feedback part
+	float h[4];
+	h[0] = 1.0f;
+	h[1] = -a1;
+	h[2] = -a1 * h[1] - a2 * h[0];
+	h[3] = -a1 * h[2] - a2 * h[1];
+
+	// g[j + 2][i] is the weight of x[n+j] in y[n+i]
+	float g[6][4];
+	for (int j = -2; j < 4; j++){
+		for (int i = 0; i < 4; i++){
+			float w = 0.0f;
+			for (int k = j < 0 ? 0 : j; k <= i; k++){
+				if (k - j <= 2)
+					w += h[i - k] * b[k - j];
+			}
+			g[j + 2][i] = w;
+		}
+	}
+
+	// c1 and c2 are the responses to y[n-1] and y[n-2] when the input is silent
+	float c1[4], c2[4];
+	c1[0] = -a1;
+	c1[1] = -a1 * c1[0] - a2;
+	c2[0] = -a2;
+	c2[1] = -a1 * c2[0];
+	for (int i = 2; i < 4; i++){
+		c1[i] = -a1 * c1[i - 1] - a2 * c1[i - 2];
+		c2[i] = -a1 * c2[i - 1] - a2 * c2[i - 2];
+	}
+
+	// spread the weights out so each one covers both channels of a sample
+	vec4 G01[6], G23[6];
+	for (int j = 0; j < 6; j++){
+		G01[j] = vec4_set(g[j][0], g[j][0], g[j][1], g[j][1]);
+		G23[j] = vec4_set(g[j][2], g[j][2], g[j][3], g[j][3]);
+	}
+	vec4 C101 = vec4_set(c1[0], c1[0], c1[1], c1[1]);
+	vec4 C123 = vec4_set(c1[2], c1[2], c1[3], c1[3]);
+	vec4 C201 = vec4_set(c2[0], c2[0], c2[1], c2[1]);
+	vec4 C223 = vec4_set(c2[2], c2[2], c2[3], c2[3]);
+
+	// x holds x[n-2] .. x[n+3] for the current block
+	sf_sample_st x[6];
+	x[0] = state->xn2;
+	x[1] = state->xn1;
+	sf_sample_st yn1 = state->yn1;
+	sf_sample_st yn2 = state->yn2;
+
+	int n = 0;
+	for (; n + 4 <= size; n += 4){
+		for (int i = 0; i < 4; i++)
+			x[i + 2] = input[n + i];
+
+		vec4 Y1 = vec4_dupsample(yn1);
+		vec4 Y2 = vec4_dupsample(yn2);
+		vec4 Y01 = vec4_add(vec4_mul(C101, Y1), vec4_mul(C201, Y2));
+		vec4 Y23 = vec4_add(vec4_mul(C123, Y1), vec4_mul(C223, Y2));
+		for (int j = 0; j < 6; j++){
+			vec4 X = vec4_dupsample(x[j]);
+			Y01 = vec4_add(Y01, vec4_mul(G01[j], X));
+			Y23 = vec4_add(Y23, vec4_mul(G23[j], X));
+		}
+
+		vec4_storesamples(&output[n], Y01);
+		vec4_storesamples(&output[n + 2], Y23);
+
+		// slide everything down one block
+		x[0] = x[4];
+		x[1] = x[5];
+		yn1 = output[n + 3];
+		yn2 = output[n + 2];
+	}
+
+	state->xn1 = x[1];
+	state->xn2 = x[0];
+	state->yn1 = yn1;
+	state->yn2 = yn2;
+
+	// finish off any leftover samples one at a time
+	if (n < size)
+		sf_biquad_process(state, size - n, &input[n], &output[n]);
+	ftz_end(ftz);
+}
+
+void sf_biquad_chain_init(sf_biquad_chain_st *chain){
+	chain->size = 0;
+}
+
+sf_biquad_state_st *sf_biquad_chain_add(sf_biquad_chain_st *chain){
+	if (chain->size >= SF_BIQUAD_CHAIN_MAX)
+		return NULL;
+	return &chain->sections[chain->size++];
+}
+
+#if SF_SIMD
+// run two sections of a chain (A followed by B) together in one vector, where A uses the first two
+// lanes and B uses the other two
+//
+// B's input is A's output, so B runs two samples behind: on each step, A filters sample n while B
+// filters sample n - 2, using A's result from two steps before -- that way B doesn't have to wait
+// on the step A just finished, and both sections cost about the same as one (instead of leaving
+// two lanes empty, like biquad_run does)
+//
+// the first two steps only run A, and two extra steps at the end only run B, so that everything
+// lines up with the state saved by biquad_run; each lane does exactly the same math as biquad_run,
+// so the results are identical to running the two sections one after the other
+static inline vec4 pair_formula(vec4 xn0, vec4 xn1, vec4 xn2, vec4 yn1, vec4 yn2, vec4 b0,
+	vec4 b1, vec4 b2, vec4 a1, vec4 a2){
+	return vec4_sub(vec4_sub(vec4_add(vec4_add(
+		vec4_mul(b0, xn0),
+		vec4_mul(b1, xn1)),
+		vec4_mul(b2, xn2)),
+		vec4_mul(a1, yn1)),
+		vec4_mul(a2, yn2));
+}
+
+// slide the lanes selected by `mask` down one sample, and leave the rest alone
+static inline void pair_slide(vec4mask mask, vec4 xn0, vec4 yn0, vec4 *xn1, vec4 *xn2, vec4 *yn1,
+	vec4 *yn2){
+	*xn2 = vec4_select(mask, *xn1, *xn2);
+	*xn1 = vec4_select(mask, xn0, *xn1);
+	*yn2 = vec4_select(mask, *yn1, *yn2);
+	*yn1 = vec4_select(mask, yn0, *yn1);
+}
+
+static void pair_run(sf_biquad_state_st *A, sf_biquad_state_st *B, int size, sf_sample_st *input,
+	sf_sample_st *output, int step){
+	if (size <= 0)
+		return;
+
+	// pull out the state of both sections into vector registers
+	vec4 b0 = vec4_set(A->b0, A->b0, B->b0, B->b0);
+	vec4 b1 = vec4_set(A->b1, A->b1, B->b1, B->b1);
+	vec4 b2 = vec4_set(A->b2, A->b2, B->b2, B->b2);
+	vec4 a1 = vec4_set(A->a1, A->a1, B->a1, B->a1);
+	vec4 a2 = vec4_set(A->a2, A->a2, B->a2, B->a2);
+	vec4 xn1 = vec4_set(A->xn1.L, A->xn1.R, B->xn1.L, B->xn1.R);
+	vec4 xn2 = vec4_set(A->xn2.L, A->xn2.R, B->xn2.L, B->xn2.R);
+	vec4 yn1 = vec4_set(A->yn1.L, A->yn1.R, B->yn1.L, B->yn1.R);
+	vec4 yn2 = vec4_set(A->yn2.L, A->yn2.R, B->yn2.L, B->yn2.R);
+	vec4mask lo = vec4_lt(vec4_set(0.0f, 0.0f, 1.0f, 1.0f), vec4_set1(0.5f)); // A's lanes
+	vec4mask hi = vec4_gt(vec4_set(0.0f, 0.0f, 1.0f, 1.0f), vec4_set1(0.5f)); // B's lanes
+	vec4 xn0, yn0;
+
+	// A on samples 0 and 1, while B's lanes are thrown away
+	for (int n = 0; n < 2 && n < size; n++){
+		xn0 = vec4_fromsample(input[n * step]);
+		yn0 = pair_formula(xn0, xn1, xn2, yn1, yn2, b0, b1, b2, a1, a2);
+		pair_slide(lo, xn0, yn0, &xn1, &xn2, &yn1, &yn2);
+	}
+
+	// A on sample n, B on sample n - 2
+	for (int n = 2; n < size; n++){
+		xn0 = vec4_set(input[n * step].L, input[n * step].R, vec4_get(yn2, 0), vec4_get(yn2, 1));
+		yn0 = pair_formula(xn0, xn1, xn2, yn1, yn2, b0, b1, b2, a1, a2);
+		output[(n - 2) * step] = (sf_sample_st){ vec4_get(yn0, 2), vec4_get(yn0, 3) };
+		xn2 = xn1;
+		xn1 = xn0;
+		yn2 = yn1;
+		yn1 = yn0;
+	}
+
+	// B on the last two samples, while A's lanes are thrown away
+	for (int n = size < 2 ? 1 : 0; n < 2; n++){
+		vec4 ya = n == 0 ? yn2 : yn1;
+		xn0 = vec4_set(0.0f, 0.0f, vec4_get(ya, 0), vec4_get(ya, 1));
+		yn0 = pair_formula(xn0, xn1, xn2, yn1, yn2, b0, b1, b2, a1, a2);
+		output[(size - 2 + n) * step] = (sf_sample_st){ vec4_get(yn0, 2), vec4_get(yn0, 3) };
+		pair_slide(hi, xn0, yn0, &xn1, &xn2, &yn1, &yn2);
+	}
+
+	// save the state for future processing
+	A->xn1 = (sf_sample_st){ vec4_get(xn1, 0), vec4_get(xn1, 1) };
+	A->xn2 = (sf_sample_st){ vec4_get(xn2, 0), vec4_get(xn2, 1) };
+	A->yn1 = (sf_sample_st){ vec4_get(yn1, 0), vec4_get(yn1, 1) };
+	A->yn2 = (sf_sample_st){ vec4_get(yn2, 0), vec4_get(yn2, 1) };
+	B->xn1 = (sf_sample_st){ vec4_get(xn1, 2), vec4_get(xn1, 3) };
+	B->xn2 = (sf_sample_st){ vec4_get(xn2, 2), vec4_get(xn2, 3) };
+	B->yn1 = (sf_sample_st){ vec4_get(yn1, 2), vec4_get(yn1, 3) };
+	B->yn2 = (sf_sample_st){ vec4_get(yn2, 2), vec4_get(yn2, 3) };
+}
+#endif
+
+// the chain runs every section over one block before moving on to the next block
+//
+// the first section reads from the input and writes to the output, and the rest of the sections
+// work in place on the output block, which is still in the cache from the previous section; with
+// SIMD, the sections are run two at a time (see pair_run)
+//
+// if `step` is -1, the blocks (and the samples inside them) are walked from the end of the buffers
+// back to the start, which runs the chain backwards in time
+static void chain_run(sf_biquad_chain_st *chain, int size, sf_sample_st *input,
+	sf_sample_st *output, int step){
+	if (chain->size <= 0){
+		if (input != output)
+			memmove(output, input, sizeof(sf_sample_st) * size);
+		return;
+	}
+	uint64_t ftz = ftz_begin();
+	for (int pos = 0; pos < size; pos += SF_BIQUAD_CHAIN_BLOCK){
+		int len = size - pos;
+		if (len > SF_BIQUAD_CHAIN_BLOCK)
+			len = SF_BIQUAD_CHAIN_BLOCK;
+		// first sample of the block, in the direction of travel
+		int first = step > 0 ? pos : size - 1 - pos;
+		sf_biquad_state_st *sec = chain->sections;
+		sf_sample_st *in = &input[first];
+		int i = 0;
+#if SF_SIMD
+		for (; i + 2 <= chain->size; i += 2){
+			pair_run(&sec[i], &sec[i + 1], len, in, &output[first], step);
+			in = &output[first];
+		}
+#endif
+		for (; i < chain->size; i++){
+			biquad_run(&sec[i], len, in, &output[first], step);
+			in = &output[first];
+		}
+	}
+	ftz_end(ftz);
+}
+
+void sf_biquad_chain_process(sf_biquad_chain_st *chain, int size, sf_sample_st *input,
+	sf_sample_st *output){
+	chain_run(chain, size, input, output, 1);
+}
+
+// the saved samples of a filter only affect the output through the feedback path, which decays
+// like the impulse response of the poles
+//
+// with poles p1 and p2, the effect of yn1/yn2 on the output n samples later is a combination of
+// sum(p1^k * p2^(n-k), k = 0..n), which is at most (n + 1) * r^n for a pole radius r, so the
+// warm-up is the first n where 2 * (n + 1) * r^n drops below the tolerance (the 2 covers both saved
+// outputs), plus 2 samples to fill xn1/xn2
+static int warmup(const sf_biquad_state_st *state, double tol){
+	double a1 = state->a1;
+	double a2 = state->a2;
+	double disc = a1 * a1 - 4.0 * a2;
+	double r;
+	if (disc < 0.0)
+		r = sqrt(a2); // complex poles, |p|^2 = p1 * p2 = a2
+	else{
+		double sq = sqrt(disc);
+		r = fmax(fabs(-a1 + sq), fabs(-a1 - sq)) * 0.5;
+	}
+	if (!(r < 1.0)) // also catches NaN
+		return -1; // the filter never settles
+	if (r < 1e-30)
+		return 2; // no feedback at all
+	double lr = log(r);
+	double n = log(tol * 0.5) / lr;
+	for (int i = 0; i < 8; i++) // fixed point iteration to account for the (n + 1) factor
+		n = log(tol * 0.5 / (n + 1.0)) / lr;
+	if (n > (double)(1 << 30))
+		return -1;
+	return (int)ceil(n) + 2;
+}
+
+int sf_biquad_warmup(const sf_biquad_state_st *state, float tolerance){
+	if (!(tolerance > 0.0f))
+		return -1;
+	return warmup(state, tolerance);
+}
+
+// parallel processing
+//
+// the sound is split into one piece per thread, and every piece except the first starts from an
+// empty copy of the filters, which runs over the samples just before the piece (the warm-up) to
+// settle into the same state the serial version would be in at that point
+//
+// the warm-up samples are copied out before any thread starts, so that processing in place doesn't
+// let one piece overwrite the samples that the next piece warms up on
+//
+// the chain is the common case here, a single biquad is just a chain with one section
+//
+// when running backwards (step = -1), the pieces are laid out from the end of the sound, and the
+// warm-up of each piece is the stretch of samples just after it
+
+// the tolerance used for the warm-up, relative to the level of the signal -- this is below the
+// resolution of a float, so the pieces blend in with the serial result
+#define PARALLEL_TOLERANCE  1e-7
+
+// don't bother splitting a sound into pieces smaller than this
+#define PARALLEL_MINPIECE   16384
+
+#if SF_THREADS
+typedef struct {
+	sf_biquad_chain_st chain;
+	pthread_t thread;
+	bool started;
+	int warmsize;
+	sf_sample_st *warm;
+	int size;
+	sf_sample_st *input;
+	sf_sample_st *output;
+	int step;
+} parallel_piece_st;
+
+static void *parallel_run(void *arg){
+	parallel_piece_st *p = (parallel_piece_st *)arg;
+	if (p->warmsize > 0)
+		chain_run(&p->chain, p->warmsize, p->warm, p->warm, p->step);
+	chain_run(&p->chain, p->size, p->input, p->output, p->step);
+	return NULL;
+}
+
+static int parallel_threads(int threads){
+	if (threads <= 0){
+		long cores = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = cores > 0 ? (int)cores : 1;
+	}
+	return threads;
+}
+
+static void chain_parallel(sf_biquad_chain_st *chain, int size, sf_sample_st *input,
+	sf_sample_st *output, int threads, int step){
+	// the warm-up of a cascade is the sum of the warm-ups of its sections, since each section has
+	// to settle on top of the one before it
+	int warmsize = 0;
+	for (int i = 0; i < chain->size; i++){
+		int w = warmup(&chain->sections[i], PARALLEL_TOLERANCE);
+		if (w < 0 || warmsize > (1 << 30) - w){
+			warmsize = -1;
+			break;
+		}
+		warmsize += w;
+	}
+
+	// every piece needs to be at least 4 times as long as its warm-up, so that the warm-up doesn't
+	// eat most of the gains
+	threads = parallel_threads(threads);
+	// (the warm-up can be up to 2^30 samples, so 4 times that doesn't fit in an int)
+	if (warmsize >= 0){
+		int64_t minpiece = warmsize > PARALLEL_MINPIECE / 4 ? (int64_t)warmsize * 4 :
+			PARALLEL_MINPIECE;
+		if (threads > size / minpiece)
+			threads = (int)(size / minpiece);
+	}
+	parallel_piece_st *pieces = NULL;
+	if (warmsize >= 0 && threads > 1){
+		pieces = sf_malloc(sizeof(parallel_piece_st) * threads +
+			sizeof(sf_sample_st) * warmsize * (threads - 1));
+	}
+	if (pieces == NULL){
+		// the filter doesn't settle, the sound is too short, or we're out of memory, so just
+		// process it serially
+		chain_run(chain, size, input, output, step);
+		return;
+	}
+	sf_sample_st *warm = (sf_sample_st *)&pieces[threads];
+
+	for (int t = 0; t < threads; t++){
+		parallel_piece_st *p = &pieces[t];
+		int start = (int)((int64_t)size * t / threads);
+		int end = (int)((int64_t)size * (t + 1) / threads);
+		if (step < 0){
+			// flip the piece around so that the first piece is at the end of the sound
+			int flip = size - end;
+			end = size - start;
+			start = flip;
+		}
+		p->chain = *chain;
+		p->size = end - start;
+		p->input = &input[start];
+		p->output = &output[start];
+		p->step = step;
+		if (t == 0){
+			// the first piece continues from the caller's state
+			p->warmsize = 0;
+			p->warm = NULL;
+		}
+		else{
+			for (int i = 0; i < p->chain.size; i++){
+				sf_biquad_state_st *s = &p->chain.sections[i];
+				s->xn1 = s->xn2 = s->yn1 = s->yn2 = (sf_sample_st){ 0, 0 };
+			}
+			p->warmsize = warmsize;
+			p->warm = &warm[warmsize * (t - 1)];
+			memcpy(p->warm, step > 0 ? &input[start - warmsize] : &input[end],
+				sizeof(sf_sample_st) * warmsize);
+		}
+	}
+
+	// run the pieces, with the calling thread taking the first one
+	//
+	// if a thread can't be started, that piece is run on the calling thread instead, which is
+	// slower but gives the same result
+	for (int t = 1; t < threads; t++){
+		pieces[t].started =
+			pthread_create(&pieces[t].thread, NULL, parallel_run, &pieces[t]) == 0;
+	}
+	parallel_run(&pieces[0]);
+	for (int t = 1; t < threads; t++){
+		if (pieces[t].started)
+			pthread_join(pieces[t].thread, NULL);
+		else
+			parallel_run(&pieces[t]);
+	}
+
+	// the state after the last piece carries over to the next call
+	for (int i = 0; i < chain->size; i++)
+		chain->sections[i] = pieces[threads - 1].chain.sections[i];
+	sf_free(pieces);
+}
+#else
+// without threads, everything runs serially
+static void chain_parallel(sf_biquad_chain_st *chain, int size, sf_sample_st *input,
+	sf_sample_st *output, int threads, int step){
+	(void)threads;
+	chain_run(chain, size, input, output, step);
+}
+#endif
+
+void sf_biquad_process_parallel(sf_biquad_state_st *state, int size, sf_sample_st *input,
+	sf_sample_st *output, int threads){
+	sf_biquad_chain_st chain;
+	chain.size = 1;
+	chain.sections[0] = *state;
+	chain_parallel(&chain, size, input, output, threads, 1);
+	*state = chain.sections[0];
+}
+
+// zero-phase filtering
+//
+// the sound is filtered forwards, and then the result is filtered again backwards, which cancels
+// out the phase shift of the filter (and squares its magnitude response)
+//
+// the ends of the sound are handled the same way as filtfilt in SciPy/MATLAB: the sound is extended
+// at both ends by an odd reflection (the samples are mirrored around the first and last sample, so
+// the slope carries on smoothly), and each pass starts with the filter already settled on the value
+// it first sees, so there's no startup thump from going from silence to the first sample
+//
+// the extensions are only 3 * (2 * sections + 1) samples long, so they live on the stack, and the
+// backward pass runs in place over the output, so no copy of the sound is ever made
+
+// length of the extension at each end
+#define FILTFILT_PAD(sections)  (3 * (2 * (sections) + 1))
+#define FILTFILT_PADMAX         FILTFILT_PAD(SF_BIQUAD_CHAIN_MAX)
+
+// set the saved samples of every section to where they would end up after a long run of `v`
+//
+// with a constant input, the output settles to the input times the gain at DC, which is
+// (b0 + b1 + b2) / (1 + a1 + a2)
+static void chain_settle(sf_biquad_chain_st *chain, sf_sample_st v){
+	for (int i = 0; i < chain->size; i++){
+		sf_biquad_state_st *s = &chain->sections[i];
+		float den = 1.0f + s->a1 + s->a2;
+		float dc = fabsf(den) < 1e-12f ? 0.0f : (s->b0 + s->b1 + s->b2) / den;
+		s->xn1 = s->xn2 = v;
+		v = (sf_sample_st){ v.L * dc, v.R * dc };
+		s->yn1 = s->yn2 = v;
+	}
+}
+
+static void filtfilt(const sf_biquad_chain_st *chain, int size, sf_sample_st *input,
+	sf_sample_st *output, int threads){
+	if (size <= 0)
+		return;
+	sf_biquad_chain_st work = *chain;
+	int pad = FILTFILT_PAD(work.size);
+	if (pad > size - 1)
+		pad = size - 1;
+
+	// build both extensions before the forward pass, since the output might be the same buffer as
+	// the input
+	sf_sample_st front[FILTFILT_PADMAX];
+	sf_sample_st back[FILTFILT_PADMAX];
+	sf_sample_st first = input[0];
+	sf_sample_st last = input[size - 1];
+	for (int i = 0; i < pad; i++){
+		sf_sample_st f = input[pad - i];
+		sf_sample_st b = input[size - 2 - i];
+		front[i] = (sf_sample_st){ 2.0f * first.L - f.L, 2.0f * first.R - f.R };
+		back[i]  = (sf_sample_st){ 2.0f * last.L  - b.L, 2.0f * last.R  - b.R };
+	}
+
+	// forward pass: front extension, the sound, then the back extension
+	chain_settle(&work, pad > 0 ? front[0] : first);
+	chain_run(&work, pad, front, front, 1);
+	if (threads == 1)
+		chain_run(&work, size, input, output, 1);
+	else
+		chain_parallel(&work, size, input, output, threads, 1);
+	chain_run(&work, pad, back, back, 1);
+
+	// backward pass: back extension, then the sound (the front extension isn't needed anymore,
+	// since it would only produce output that gets thrown away)
+	chain_settle(&work, pad > 0 ? back[pad - 1] : output[size - 1]);
+	chain_run(&work, pad, back, back, -1);
+	if (threads == 1)
+		chain_run(&work, size, output, output, -1);
+	else
+		chain_parallel(&work, size, output, output, threads, -1);
+}
+
+void sf_biquad_filtfilt(const sf_biquad_chain_st *chain, int size, sf_sample_st *input,
+	sf_sample_st *output){
+	filtfilt(chain, size, input, output, 1);
+}
+
+void sf_biquad_filtfilt_parallel(const sf_biquad_chain_st *chain, int size, sf_sample_st *input,
+	sf_sample_st *output, int threads){
+	filtfilt(chain, size, input, output, threads);
+}
+
+// frequency response
+//
+// the response at angular frequency w is H = B(e^-jw) / A(e^-jw), where B and A are the
+// polynomials b0 + b1 z^-1 + b2 z^-2 and 1 + a1 z^-1 + a2 z^-2
+//
+// written directly with cos(w) and cos(2w), the real part of A for a low cutoff is the difference
+// of numbers around 1 and 2 that nearly cancel out, which loses most of the precision of a float
+// (and the same thing happens to B near rate/2 for a lowpass); instead, everything is written in
+// terms of p = sin(w/2)^2 and q = cos(w/2)^2, which gives:
+//
+//   re = (b0 + b1 + b2) q^2 + (b0 - b1 + b2) p^2 + (2 b0 - 6 b2) p q
+//   im = -sin(w) ((b1 + 2 b2) q + (b1 - 2 b2) p)
+//
+// the sums that cancel out are computed once per section in double precision, and near 0Hz (where
+// p is tiny) and near rate/2 (where q is tiny) the result is dominated by one accurate term
+//
+// four frequencies are evaluated at once, one per vector lane, and every section's response is
+// multiplied into the total as a complex number
+
+typedef struct {
+	vec4 bq, bp, bpq, bi1, bi2; // numerator
+	vec4 aq, ap, apq, ai1, ai2; // denominator
+} response_terms_st;
+
+static void response_terms(const sf_biquad_state_st *state, response_terms_st *rt){
+	double b0 = state->b0, b1 = state->b1, b2 = state->b2;
+	double a1 = state->a1, a2 = state->a2;
+	rt->bq  = vec4_set1((float)(b0 + b1 + b2));
+	rt->bp  = vec4_set1((float)(b0 - b1 + b2));
+	rt->bpq = vec4_set1((float)(2.0 * b0 - 6.0 * b2));
+	rt->bi1 = vec4_set1((float)(-(b1 + 2.0 * b2)));
+	rt->bi2 = vec4_set1((float)(-(b1 - 2.0 * b2)));
+	rt->aq  = vec4_set1((float)(1.0 + a1 + a2));
+	rt->ap  = vec4_set1((float)(1.0 - a1 + a2));
+	rt->apq = vec4_set1((float)(2.0 - 6.0 * a2));
+	rt->ai1 = vec4_set1((float)(-(a1 + 2.0 * a2)));
+	rt->ai2 = vec4_set1((float)(-(a1 - 2.0 * a2)));
+}
+
+static void response(const sf_biquad_state_st *sections, int nsections, int rate, int count,
+	const float *freqs, float *mag, float *phase){
+	response_terms_st rt[SF_BIQUAD_CHAIN_MAX];
+	for (int i = 0; i < nsections; i++)
+		response_terms(&sections[i], &rt[i]);
+	float halfw = (float)M_PI / (float)rate; // w/2 per Hz
+
+	for (int pos = 0; pos < count; pos += 4){
+		int len = count - pos < 4 ? count - pos : 4;
+
+		// load the next 4 frequencies (padded with zeros at the end)
+		vec4 h;
+		if (len == 4)
+			h = vec4_load(&freqs[pos]);
+		else{
+			float fl[4] = { 0, 0, 0, 0 };
+			for (int i = 0; i < len; i++)
+				fl[i] = freqs[pos + i];
+			h = vec4_load(fl);
+		}
+
+		// calculate sin(w/2) and cos(w/2) for each lane
+		//
+		// everything repeats every pi of w/2, so w/2 is wrapped into [-pi/2, pi/2] first, then
+		// sin(w/2) is doubled up from the sin and cos of w/4, and cos(w/2) is doubled up from the
+		// sin and cos of (pi/2 - |w/2|) / 2, so that it stays accurate as it goes to 0 at rate/2
+		h = vec4_mul(h, vec4_set1(halfw));
+		vec4 k = vec4_round(vec4_mul(h, vec4_set1((float)M_1_PI)));
+		h = vec4_sub(vec4_sub(h, vec4_mul(k, vec4_set1(3.14159274f))),
+			vec4_mul(k, vec4_set1(-8.74227766e-8f))); // pi split in two for accuracy
+		vec4 u = vec4_mul(h, vec4_set1(0.5f));
+		vec4 v = vec4_sub(vec4_set1(0.785398163f), vec4_abs(u));
+		vec4 su, cu, sv, cv;
+		vec4_sincos(u, &su, &cu);
+		vec4_sincos(v, &sv, &cv);
+		vec4 sh = vec4_mul(vec4_set1(2.0f), vec4_mul(su, cu));
+		vec4 ch = vec4_mul(vec4_set1(2.0f), vec4_mul(sv, cv));
+		vec4 p = vec4_mul(sh, sh);
+		vec4 q = vec4_mul(ch, ch);
+		vec4 pp = vec4_mul(p, p);
+		vec4 qq = vec4_mul(q, q);
+		vec4 pq = vec4_mul(p, q);
+		vec4 s = vec4_mul(vec4_set1(2.0f), vec4_mul(sh, ch)); // sin(w)
+
+		// multiply together the response of every section
+		vec4 hr = vec4_set1(1.0f);
+		vec4 hi = vec4_set1(0.0f);
+		for (int i = 0; i < nsections; i++){
+			response_terms_st *t = &rt[i];
+			vec4 nr = vec4_add(vec4_add(vec4_mul(t->bq, qq), vec4_mul(t->bp, pp)),
+				vec4_mul(t->bpq, pq));
+			vec4 ni = vec4_mul(s, vec4_add(vec4_mul(t->bi1, q), vec4_mul(t->bi2, p)));
+			vec4 dr = vec4_add(vec4_add(vec4_mul(t->aq, qq), vec4_mul(t->ap, pp)),
+				vec4_mul(t->apq, pq));
+			vec4 di = vec4_mul(s, vec4_add(vec4_mul(t->ai1, q), vec4_mul(t->ai2, p)));
+			// (nr + j ni) / (dr + j di)
+			vec4 dd = vec4_add(vec4_mul(dr, dr), vec4_mul(di, di));
+			vec4 qr = vec4_div(vec4_add(vec4_mul(nr, dr), vec4_mul(ni, di)), dd);
+			vec4 qi = vec4_div(vec4_sub(vec4_mul(ni, dr), vec4_mul(nr, di)), dd);
+			vec4 tr = vec4_sub(vec4_mul(hr, qr), vec4_mul(hi, qi));
+			hi = vec4_add(vec4_mul(hr, qi), vec4_mul(hi, qr));
+			hr = tr;
+		}
+
+		// convert to magnitude and phase
+		if (mag){
+			vec4 m2 = vec4_add(vec4_mul(hr, hr), vec4_mul(hi, hi));
+			for (int i = 0; i < len; i++)
+				mag[pos + i] = sqrtf(vec4_get(m2, i));
+		}
+		if (phase){
+			vec4 ph = vec4_atan2(hi, hr);
+			for (int i = 0; i < len; i++)
+				phase[pos + i] = vec4_get(ph, i);
+		}
+	}
+}
+
+void sf_biquad_response(const sf_biquad_state_st *state, int rate, int count, const float *freqs,
+	float *mag, float *phase){
+	response(state, 1, rate, count, freqs, mag, phase);
+}
+
+void sf_biquad_chain_response(const sf_biquad_chain_st *chain, int rate, int count,
+	const float *freqs, float *mag, float *phase){
+	response(chain->sections, chain->size, rate, count, freqs, mag, phase);
+}
+
+void sf_biquad_bank_init(sf_biquad_bank_st *bank, int size){
+	if (size < 0)
+		size = 0;
+	else if (size > SF_BIQUAD_BANK_MAX)
+		size = SF_BIQUAD_BANK_MAX;
+	memset(bank, 0, sizeof(sf_biquad_bank_st));
+	bank->size = size;
+	for (int i = 0; i < SF_BIQUAD_BANK_MAX; i++)
+		bank->b0[i] = 1.0f;
+}
+
+void sf_biquad_bank_set(sf_biquad_bank_st *bank, int stream, const sf_biquad_state_st *state){
+	if (stream < 0 || stream >= SF_BIQUAD_BANK_MAX)
+		return;
+	bank->b0[stream]   = state->b0;
+	bank->b1[stream]   = state->b1;
+	bank->b2[stream]   = state->b2;
+	bank->a1[stream]   = state->a1;
+	bank->a2[stream]   = state->a2;
+	bank->xn1L[stream] = state->xn1.L;
+	bank->xn1R[stream] = state->xn1.R;
+	bank->xn2L[stream] = state->xn2.L;
+	bank->xn2R[stream] = state->xn2.R;
+	bank->yn1L[stream] = state->yn1.L;
+	bank->yn1R[stream] = state->yn1.R;
+	bank->yn2L[stream] = state->yn2.L;
+	bank->yn2R[stream] = state->yn2.R;
+}
+
+void sf_biquad_bank_get(const sf_biquad_bank_st *bank, int stream, sf_biquad_state_st *state){
+	if (stream < 0 || stream >= SF_BIQUAD_BANK_MAX)
+		return;
+	state->b0  = bank->b0[stream];
+	state->b1  = bank->b1[stream];
+	state->b2  = bank->b2[stream];
+	state->a1  = bank->a1[stream];
+	state->a2  = bank->a2[stream];
+	state->xn1 = (sf_sample_st){ bank->xn1L[stream], bank->xn1R[stream] };
+	state->xn2 = (sf_sample_st){ bank->xn2L[stream], bank->xn2R[stream] };
+	state->yn1 = (sf_sample_st){ bank->yn1L[stream], bank->yn1R[stream] };
+	state->yn2 = (sf_sample_st){ bank->yn2L[stream], bank->yn2R[stream] };
+}
+
+// process a group of up to 4 streams, one stream per vector lane
+//
+// the arithmetic is the same as sf_biquad_process, but every lane is an independent filter, so the
+// feedback chains of the streams overlap instead of waiting on each other
+//
+// if the group has less than 4 streams, the extra lanes filter silence from a scratch block, which
+// is why the sound is walked through in blocks
+#define BANK_LANES  4
+#define BANK_BLOCK  256
+static void bank_group(sf_biquad_bank_st *bank, int first, int lanes, int size,
+	sf_sample_st **input, sf_sample_st **output){
+	vec4 b0 = vec4_load(&bank->b0[first]);
+	vec4 b1 = vec4_load(&bank->b1[first]);
+	vec4 b2 = vec4_load(&bank->b2[first]);
+	vec4 a1 = vec4_load(&bank->a1[first]);
+	vec4 a2 = vec4_load(&bank->a2[first]);
+	vec4 xn1L = vec4_load(&bank->xn1L[first]), xn1R = vec4_load(&bank->xn1R[first]);
+	vec4 xn2L = vec4_load(&bank->xn2L[first]), xn2R = vec4_load(&bank->xn2R[first]);
+	vec4 yn1L = vec4_load(&bank->yn1L[first]), yn1R = vec4_load(&bank->yn1R[first]);
+	vec4 yn2L = vec4_load(&bank->yn2L[first]), yn2R = vec4_load(&bank->yn2R[first]);
+
+	sf_sample_st silence[BANK_BLOCK];
+	sf_sample_st scratch[BANK_BLOCK];
+	if (lanes < BANK_LANES)
+		memset(silence, 0, sizeof(silence));
+
+	for (int pos = 0; pos < size; pos += BANK_BLOCK){
+		int len = size - pos;
+		if (len > BANK_BLOCK)
+			len = BANK_BLOCK;
+
+		sf_sample_st *in[BANK_LANES];
+		sf_sample_st *out[BANK_LANES];
+		for (int i = 0; i < BANK_LANES; i++){
+			in[i]  = i < lanes ? &input[first + i][pos] : silence;
+			out[i] = i < lanes ? &output[first + i][pos] : scratch;
+		}
+
+		for (int n = 0; n < len; n++){
+			// gather the current sample of each stream into the lanes
+			sf_sample_st x0 = in[0][n], x1 = in[1][n], x2 = in[2][n], x3 = in[3][n];
+			vec4 xn0L = vec4_set(x0.L, x1.L, x2.L, x3.L);
+			vec4 xn0R = vec4_set(x0.R, x1.R, x2.R, x3.R);
+
+			vec4 yn0L = vec4_sub(vec4_sub(vec4_add(vec4_add(
+				vec4_mul(b0, xn0L), vec4_mul(b1, xn1L)), vec4_mul(b2, xn2L)),
+				vec4_mul(a1, yn1L)), vec4_mul(a2, yn2L));
+			vec4 yn0R = vec4_sub(vec4_sub(vec4_add(vec4_add(
+				vec4_mul(b0, xn0R), vec4_mul(b1, xn1R)), vec4_mul(b2, xn2R)),
+				vec4_mul(a1, yn1R)), vec4_mul(a2, yn2R));
+
+			// scatter the results back out to each stream
+			out[0][n] = (sf_sample_st){ vec4_get(yn0L, 0), vec4_get(yn0R, 0) };
+			out[1][n] = (sf_sample_st){ vec4_get(yn0L, 1), vec4_get(yn0R, 1) };
+			out[2][n] = (sf_sample_st){ vec4_get(yn0L, 2), vec4_get(yn0R, 2) };
+			out[3][n] = (sf_sample_st){ vec4_get(yn0L, 3), vec4_get(yn0R, 3) };
+
+			// slide everything down one sample
+			xn2L = xn1L; xn2R = xn1R;
+			xn1L = xn0L; xn1R = xn0R;
+			yn2L = yn1L; yn2R = yn1R;
+			yn1L = yn0L; yn1R = yn0R;
+		}
+	}
+
+	// save the state for future processing
+	vec4_store(&bank->xn1L[first], xn1L); vec4_store(&bank->xn1R[first], xn1R);
+	vec4_store(&bank->xn2L[first], xn2L); vec4_store(&bank->xn2R[first], xn2R);
+	vec4_store(&bank->yn1L[first], yn1L); vec4_store(&bank->yn1R[first], yn1R);
+	vec4_store(&bank->yn2L[first], yn2L); vec4_store(&bank->yn2R[first], yn2R);
+}
+
+void sf_biquad_bank_process(sf_biquad_bank_st *bank, int size, sf_sample_st **input,
+	sf_sample_st **output){
+	uint64_t ftz = ftz_begin();
+	int first = 0;
+	for (; first + BANK_LANES <= bank->size; first += BANK_LANES)
+		bank_group(bank, first, BANK_LANES, size, input, output);
+	if (first < bank->size)
+		bank_group(bank, first, bank->size - first, size, input, output);
+	ftz_end(ftz);
+}
+
+// fixed point
+//
+// the coefficients are stored as integers scaled by 2^shift, where the shift is as large as
+// possible while still fitting the biggest coefficient in 31 bits, and the formula is accumulated
+// in 64 bits, which can't overflow: each product is at most 2^31 * 2^16, and there are 5 of them
+//
+// the accumulated value has `shift` bits below the output sample, which get rounded away -- but in
+// a feedback loop, that rounding gets amplified by the filter (a lot, for low cutoffs, where both
+// poles sit next to 0Hz, and for cutoffs near nyquist, where they sit next to it), so instead of
+// throwing the bits away, they're fed back into the next two samples through the filter's own
+// feedback coefficients, as -a1 * e[n-1] - a2 * e[n-2]; that filters the rounding noise by the
+// same 1 + a1 z^-1 + a2 z^-2 that the poles divide it by, so the two cancel out wherever the poles
+// are, and the output is the exact result rounded to the nearest integer
+//
+// each error is below 2^(shift - 1) and each coefficient below 2^31, so the products fit in 64 bits
+
+void sf_biquad_fixed_init(sf_biquad_fixed_st *fixed, const sf_biquad_state_st *state){
+	double coef[5] = { state->b0, state->b1, state->b2, state->a1, state->a2 };
+	double big = 0.0;
+	for (int i = 0; i < 5; i++){
+		if (fabs(coef[i]) > big)
+			big = fabs(coef[i]);
+	}
+	int shift = 30;
+	while (shift > 0 && big * (double)(1 << shift) >= 2147483647.0)
+		shift--;
+	int32_t q[5];
+	for (int i = 0; i < 5; i++){
+		double v = round(coef[i] * (double)(1 << shift));
+		q[i] = v > 2147483647.0 ? 2147483647 : v < -2147483647.0 ? -2147483647 : (int32_t)v;
+	}
+	memset(fixed, 0, sizeof(sf_biquad_fixed_st));
+	fixed->b0 = q[0];
+	fixed->b1 = q[1];
+	fixed->b2 = q[2];
+	fixed->a1 = q[3];
+	fixed->a2 = q[4];
+	fixed->shift = shift;
+}
+
+// one channel of one sample
+static inline int16_t fixed_step(int32_t b0, int32_t b1, int32_t b2, int32_t a1, int32_t a2,
+	int shift, int32_t xn0, int32_t *xn1, int32_t *xn2, int32_t *yn1, int32_t *yn2, int64_t *en1,
+	int64_t *en2){
+	int64_t acc = ((-(int64_t)a1 * *en1 - (int64_t)a2 * *en2) >> shift) +
+		(int64_t)b0 * xn0 +
+		(int64_t)b1 * *xn1 +
+		(int64_t)b2 * *xn2 -
+		(int64_t)a1 * *yn1 -
+		(int64_t)a2 * *yn2;
+	// round to the nearest integer, and feed the rest back in
+	int64_t y = (acc + (shift > 0 ? (int64_t)1 << (shift - 1) : 0)) >> shift;
+	int64_t en0 = acc - (y << shift);
+	if (y > 32767){
+		y = 32767;
+		en0 = 0;
+	}
+	else if (y < -32768){
+		y = -32768;
+		en0 = 0;
+	}
+	*en2 = *en1;
+	*en1 = en0;
+	*xn2 = *xn1;
+	*xn1 = xn0;
+	*yn2 = *yn1;
+	*yn1 = (int32_t)y;
+	return (int16_t)y;
+}
+
+void sf_biquad_fixed_process(sf_biquad_fixed_st *state, int size, const int16_t *input,
+	int16_t *output){
+	// pull out the state into local variables
+	int32_t b0 = state->b0;
+	int32_t b1 = state->b1;
+	int32_t b2 = state->b2;
+	int32_t a1 = state->a1;
+	int32_t a2 = state->a2;
+	int shift = state->shift;
+	int32_t xn1L = state->xn1L, xn1R = state->xn1R;
+	int32_t xn2L = state->xn2L, xn2R = state->xn2R;
+	int32_t yn1L = state->yn1L, yn1R = state->yn1R;
+	int32_t yn2L = state->yn2L, yn2R = state->yn2R;
+	int64_t en1L = state->en1L, en1R = state->en1R;
+	int64_t en2L = state->en2L, en2R = state->en2R;
+
+	// loop for each sample (the two channels don't depend on each other, so their steps overlap)
+	for (int n = 0; n < size; n++){
+		int16_t L = fixed_step(b0, b1, b2, a1, a2, shift, input[n * 2 + 0],
+			&xn1L, &xn2L, &yn1L, &yn2L, &en1L, &en2L);
+		int16_t R = fixed_step(b0, b1, b2, a1, a2, shift, input[n * 2 + 1],
+			&xn1R, &xn2R, &yn1R, &yn2R, &en1R, &en2R);
+		output[n * 2 + 0] = L;
+		output[n * 2 + 1] = R;
+	}
+
+	// save the state for future processing
+	state->xn1L = xn1L; state->xn1R = xn1R;
+	state->xn2L = xn2L; state->xn2R = xn2R;
+	state->yn1L = yn1L; state->yn1R = yn1R;
+	state->yn2L = yn2L; state->yn2R = yn2R;
+	state->en1L = en1L; state->en1R = en1R;
+	state->en2L = en2L; state->en2R = en2R;
 }
 
 // each type of filter just has some magic math to setup the coefficients
@@ -100,8 +1065,24 @@ static inline void state_zero(sf_biquad_state_st *state){
 	state_scale(state, 0.0f);
 }
 
+// the designs below are shared by the normal and the fast versions of the API; the `fast` flag
+// picks which math functions are used (see fastmath.h for the approximations)
+static inline void dsincos(float x, float *s, float *c, bool fast){
+	if (fast)
+		fast_sincosf(x, s, c);
+	else{
+		*s = sinf(x);
+		*c = cosf(x);
+	}
+}
+
+static inline float dpow10(float x, bool fast){
+	return fast ? fast_pow10f(x) : powf(10.0f, x);
+}
+
 // initialize the biquad state to be a lowpass filter
-void sf_lowpass(sf_biquad_state_st *state, int rate, float cutoff, float resonance){
+static inline void lowpass(sf_biquad_state_st *state, int rate, float cutoff, float resonance,
+	bool fast){
 	state_reset(state);
 	float nyquist = rate * 0.5f;
 	cutoff /= nyquist;
@@ -111,10 +1092,11 @@ void sf_lowpass(sf_biquad_state_st *state, int rate, float cutoff, float resonan
 	else if (cutoff <= 0.0f)
 		state_zero(state);
 	else{
-		resonance = powf(10.0f, resonance * 0.05f); // convert resonance from dB to linear
+		resonance = dpow10(resonance * 0.05f, fast); // convert resonance from dB to linear
 		float theta = (float)M_PI * 2.0f * cutoff;
-		float alpha = sinf(theta) / (2.0f * resonance);
-		float cosw  = cosf(theta);
+		float sinw, cosw;
+		dsincos(theta, &sinw, &cosw, fast);
+		float alpha = sinw / (2.0f * resonance);
 		float beta  = (1.0f - cosw) * 0.5f;
 		float a0inv = 1.0f / (1.0f + alpha);
 		state->b0 = a0inv * beta;
@@ -125,7 +1107,8 @@ void sf_lowpass(sf_biquad_state_st *state, int rate, float cutoff, float resonan
 	}
 }
 
-void sf_highpass(sf_biquad_state_st *state, int rate, float cutoff, float resonance){
+static inline void highpass(sf_biquad_state_st *state, int rate, float cutoff, float resonance,
+	bool fast){
 	state_reset(state);
 	float nyquist = rate * 0.5f;
 	cutoff /= nyquist;
@@ -135,10 +1118,11 @@ void sf_highpass(sf_biquad_state_st *state, int rate, float cutoff, float resona
 	else if (cutoff <= 0.0f)
 		state_passthrough(state);
 	else{
-		resonance = powf(10.0f, resonance * 0.05f); // convert resonance from dB to linear
+		resonance = dpow10(resonance * 0.05f, fast); // convert resonance from dB to linear
 		float theta = (float)M_PI * 2.0f * cutoff;
-		float alpha = sinf(theta) / (2.0f * resonance);
-		float cosw  = cosf(theta);
+		float sinw, cosw;
+		dsincos(theta, &sinw, &cosw, fast);
+		float alpha = sinw / (2.0f * resonance);
 		float beta  = (1.0f + cosw) * 0.5f;
 		float a0inv = 1.0f / (1.0f + alpha);
 		state->b0 = a0inv * beta;
@@ -149,7 +1133,8 @@ void sf_highpass(sf_biquad_state_st *state, int rate, float cutoff, float resona
 	}
 }
 
-void sf_bandpass(sf_biquad_state_st *state, int rate, float freq, float Q){
+static inline void bandpass(sf_biquad_state_st *state, int rate, float freq, float Q,
+	bool fast){
 	state_reset(state);
 	float nyquist = rate * 0.5f;
 	freq /= nyquist;
@@ -160,8 +1145,9 @@ void sf_bandpass(sf_biquad_state_st *state, int rate, float freq, float Q){
 		state_passthrough(state);
 	else{
 		float w0    = (float)M_PI * 2.0f * freq;
-		float alpha = sinf(w0) / (2.0f * Q);
-		float k     = cosf(w0);
+		float sinw, k;
+		dsincos(w0, &sinw, &k, fast);
+		float alpha = sinw / (2.0f * Q);
 		float a0inv = 1.0f / (1.0f + alpha);
 		state->b0 = a0inv * alpha;
 		state->b1 = 0;
@@ -171,7 +1157,8 @@ void sf_bandpass(sf_biquad_state_st *state, int rate, float freq, float Q){
 	}
 }
 
-void sf_notch(sf_biquad_state_st *state, int rate, float freq, float Q){
+static inline void notch(sf_biquad_state_st *state, int rate, float freq, float Q,
+	bool fast){
 	state_reset(state);
 	float nyquist = rate * 0.5f;
 	freq /= nyquist;
@@ -182,8 +1169,9 @@ void sf_notch(sf_biquad_state_st *state, int rate, float freq, float Q){
 		state_zero(state);
 	else{
 		float w0    = (float)M_PI * 2.0f * freq;
-		float alpha = sinf(w0) / (2.0f * Q);
-		float k     = cosf(w0);
+		float sinw, k;
+		dsincos(w0, &sinw, &k, fast);
+		float alpha = sinw / (2.0f * Q);
 		float a0inv = 1.0f / (1.0f + alpha);
 		state->b0 = a0inv;
 		state->b1 = a0inv * -2.0f * k;
@@ -193,7 +1181,8 @@ void sf_notch(sf_biquad_state_st *state, int rate, float freq, float Q){
 	}
 }
 
-void sf_peaking(sf_biquad_state_st *state, int rate, float freq, float Q, float gain){
+static inline void peaking(sf_biquad_state_st *state, int rate, float freq, float Q, float gain,
+	bool fast){
 	state_reset(state);
 	float nyquist = rate * 0.5f;
 	freq /= nyquist;
@@ -203,7 +1192,7 @@ void sf_peaking(sf_biquad_state_st *state, int rate, float freq, float Q, float
 		return;
 	}
 
-	float A = powf(10.0f, gain * 0.025f); // square root of gain converted from dB to linear
+	float A = dpow10(gain * 0.025f, fast); // square root of gain converted from dB to linear
 
 	if (Q <= 0.0f){
 		state_scale(state, A * A); // scale by A squared
@@ -211,8 +1200,9 @@ void sf_peaking(sf_biquad_state_st *state, int rate, float freq, float Q, float
 	}
 
 	float w0    = (float)M_PI * 2.0f * freq;
-	float alpha = sinf(w0) / (2.0f * Q);
-	float k     = cosf(w0);
+	float sinw, k;
+	dsincos(w0, &sinw, &k, fast);
+	float alpha = sinw / (2.0f * Q);
 	float a0inv = 1.0f / (1.0f + alpha / A);
 	state->b0 = a0inv * (1.0f + alpha * A);
 	state->b1 = a0inv * -2.0f * k;
@@ -221,7 +1211,8 @@ void sf_peaking(sf_biquad_state_st *state, int rate, float freq, float Q, float
 	state->a2 = a0inv * (1.0f - alpha / A);
 }
 
-void sf_allpass(sf_biquad_state_st *state, int rate, float freq, float Q){
+static inline void allpass(sf_biquad_state_st *state, int rate, float freq, float Q,
+	bool fast){
 	state_reset(state);
 	float nyquist = rate * 0.5f;
 	freq /= nyquist;
@@ -232,8 +1223,9 @@ void sf_allpass(sf_biquad_state_st *state, int rate, float freq, float Q){
 		state_scale(state, -1.0f); // invert the sample
 	else{
 		float w0    = (float)M_PI * 2.0f * freq;
-		float alpha = sinf(w0) / (2.0f * Q);
-		float k     = cosf(w0);
+		float sinw, k;
+		dsincos(w0, &sinw, &k, fast);
+		float alpha = sinw / (2.0f * Q);
 		float a0inv = 1.0f / (1.0f + alpha);
 		state->b0 = a0inv * (1.0f - alpha);
 		state->b1 = a0inv * -2.0f * k;
@@ -244,7 +1236,8 @@ void sf_allpass(sf_biquad_state_st *state, int rate, float freq, float Q){
 }
 
 // WebAudio hardcodes Q=1
-void sf_lowshelf(sf_biquad_state_st *state, int rate, float freq, float Q, float gain){
+static inline void lowshelf(sf_biquad_state_st *state, int rate, float freq, float Q, float gain,
+	bool fast){
 	state_reset(state);
 	float nyquist = rate * 0.5f;
 	freq /= nyquist;
@@ -254,7 +1247,7 @@ void sf_lowshelf(sf_biquad_state_st *state, int rate, float freq, float Q, float
 		return;
 	}
 
-	float A = powf(10.0f, gain * 0.025f); // square root of gain converted from dB to linear
+	float A = dpow10(gain * 0.025f, fast); // square root of gain converted from dB to linear
 
 	if (freq >= 1.0f){
 		state_scale(state, A * A); // scale by A squared
@@ -265,8 +1258,9 @@ void sf_lowshelf(sf_biquad_state_st *state, int rate, float freq, float Q, float
 	float ainn  = (A + 1.0f / A) * (1.0f / Q - 1.0f) + 2.0f;
 	if (ainn < 0)
 		ainn = 0;
-	float alpha = 0.5f * sinf(w0) * sqrtf(ainn);
-	float k     = cosf(w0);
+	float sinw, k;
+	dsincos(w0, &sinw, &k, fast);
+	float alpha = 0.5f * sinw * sqrtf(ainn);
 	float k2    = 2.0f * sqrtf(A) * alpha;
 	float Ap1   = A + 1.0f;
 	float Am1   = A - 1.0f;
@@ -279,7 +1273,8 @@ void sf_lowshelf(sf_biquad_state_st *state, int rate, float freq, float Q, float
 }
 
 // WebAudio hardcodes Q=1
-void sf_highshelf(sf_biquad_state_st *state, int rate, float freq, float Q, float gain){
+static inline void highshelf(sf_biquad_state_st *state, int rate, float freq, float Q, float gain,
+	bool fast){
 	state_reset(state);
 	float nyquist = rate * 0.5f;
 	freq /= nyquist;
@@ -289,7 +1284,7 @@ void sf_highshelf(sf_biquad_state_st *state, int rate, float freq, float Q, floa
 		return;
 	}
 
-	float A = powf(10.0f, gain * 0.025f); // square root of gain converted from dB to linear
+	float A = dpow10(gain * 0.025f, fast); // square root of gain converted from dB to linear
 
 	if (freq <= 0.0f){
 		state_scale(state, A * A); // scale by A squared
@@ -300,8 +1295,9 @@ void sf_highshelf(sf_biquad_state_st *state, int rate, float freq, float Q, floa
 	float ainn  = (A + 1.0f / A) * (1.0f / Q - 1.0f) + 2.0f;
 	if (ainn < 0)
 		ainn = 0;
-	float alpha = 0.5f * sinf(w0) * sqrtf(ainn);
-	float k     = cosf(w0);
+	float sinw, k;
+	dsincos(w0, &sinw, &k, fast);
+	float alpha = 0.5f * sinw * sqrtf(ainn);
 	float k2    = 2.0f * sqrtf(A) * alpha;
 	float Ap1   = A + 1.0f;
 	float Am1   = A - 1.0f;
@@ -312,3 +1308,227 @@ void sf_highshelf(sf_biquad_state_st *state, int rate, float freq, float Q, floa
 	state->a1 = a0inv * 2.0f * (Am1 - Ap1 * k);
 	state->a2 = a0inv * (Ap1 - Am1 * k - k2);
 }
+
+void sf_lowpass(sf_biquad_state_st *state, int rate, float cutoff, float resonance){
+	lowpass(state, rate, cutoff, resonance, false);
+}
+
+void sf_highpass(sf_biquad_state_st *state, int rate, float cutoff, float resonance){
+	highpass(state, rate, cutoff, resonance, false);
+}
+
+void sf_bandpass(sf_biquad_state_st *state, int rate, float freq, float Q){
+	bandpass(state, rate, freq, Q, false);
+}
+
+void sf_notch(sf_biquad_state_st *state, int rate, float freq, float Q){
+	notch(state, rate, freq, Q, false);
+}
+
+void sf_peaking(sf_biquad_state_st *state, int rate, float freq, float Q, float gain){
+	peaking(state, rate, freq, Q, gain, false);
+}
+
+void sf_allpass(sf_biquad_state_st *state, int rate, float freq, float Q){
+	allpass(state, rate, freq, Q, false);
+}
+
+void sf_lowshelf(sf_biquad_state_st *state, int rate, float freq, float Q, float gain){
+	lowshelf(state, rate, freq, Q, gain, false);
+}
+
+void sf_highshelf(sf_biquad_state_st *state, int rate, float freq, float Q, float gain){
+	highshelf(state, rate, freq, Q, gain, false);
+}
+
+static inline void design(sf_biquad_state_st *state, sf_biquad_type type, int rate, float freq,
+	float Q, float gain, bool fast){
+	switch (type){
+		case SF_BIQUAD_LOWPASS  : lowpass  (state, rate, freq, Q, fast);       break;
+		case SF_BIQUAD_HIGHPASS : highpass (state, rate, freq, Q, fast);       break;
+		case SF_BIQUAD_BANDPASS : bandpass (state, rate, freq, Q, fast);       break;
+		case SF_BIQUAD_NOTCH    : notch    (state, rate, freq, Q, fast);       break;
+		case SF_BIQUAD_PEAKING  : peaking  (state, rate, freq, Q, gain, fast); break;
+		case SF_BIQUAD_ALLPASS  : allpass  (state, rate, freq, Q, fast);       break;
+		case SF_BIQUAD_LOWSHELF : lowshelf (state, rate, freq, Q, gain, fast); break;
+		case SF_BIQUAD_HIGHSHELF: highshelf(state, rate, freq, Q, gain, fast); break;
+	}
+}
+
+void sf_biquad_design(sf_biquad_state_st *state, sf_biquad_type type, int rate, float freq,
+	float Q, float gain){
+	design(state, type, rate, freq, Q, gain, false);
+}
+
+void sf_biquad_design_fast(sf_biquad_state_st *state, sf_biquad_type type, int rate, float freq,
+	float Q, float gain){
+	design(state, type, rate, freq, Q, gain, true);
+}
+
+// higher order designs
+//
+// an Nth order Butterworth filter has N poles spread evenly around the left half of a circle in
+// the s-plane, at angles theta = pi * (2k + 1) / (2N) from the imaginary axis; each pair of poles
+// becomes one second order section with a Q of 1 / (2 sin(theta)), and an odd order has one
+// pole left over on the real axis, which becomes a first order section (a biquad with b2 = a2 = 0)
+//
+// the sections are made with the bilinear transform, with the frequency warped so that the cutoff
+// lands exactly where it was asked for; unlike the designs above, everything is in double
+// precision, since high orders with low cutoffs need it
+
+// append one section, where the s-plane prototype is (n0 + n1 s + n2 s^2) / (1 + d1 s + d2 s^2)
+// evaluated at s / K, and K = tan(pi * freq / rate) is the warped frequency
+static void design_section(sf_biquad_state_st *state, double K, double n0, double n1, double n2,
+	double d1, double d2){
+	// substitute s = (1 - z^-1) / (1 + z^-1) and multiply through by K^2 (1 + z^-1)^2
+	double KK = K * K;
+	double B0 = n0 * KK + n1 * K + n2;
+	double B1 = 2.0 * (n0 * KK - n2);
+	double B2 = n0 * KK - n1 * K + n2;
+	double A0 = KK + d1 * K + d2;
+	double A1 = 2.0 * (KK - d2);
+	double A2 = KK - d1 * K + d2;
+	state_reset(state);
+	state->b0 = (float)(B0 / A0);
+	state->b1 = (float)(B1 / A0);
+	state->b2 = (float)(B2 / A0);
+	state->a1 = (float)(A1 / A0);
+	state->a2 = (float)(A2 / A0);
+}
+
+// same as design_section for a first order prototype (n0 + n1 s) / (1 + s), which gets its own
+// version so that it doesn't end up with a pole and zero cancelling each other out at z = -1
+static void design_section1(sf_biquad_state_st *state, double K, double n0, double n1){
+	// substitute s = (1 - z^-1) / (1 + z^-1) and multiply through by K (1 + z^-1)
+	double A0 = K + 1.0;
+	state_reset(state);
+	state->b0 = (float)((n0 * K + n1) / A0);
+	state->b1 = (float)((n0 * K - n1) / A0);
+	state->b2 = 0.0f;
+	state->a1 = (float)((K - 1.0) / A0);
+	state->a2 = 0.0f;
+}
+
+// append the sections of an Nth order Butterworth to a chain (assumes there's room)
+static void butterworth(sf_biquad_chain_st *chain, sf_biquad_type type, int order, int rate,
+	float freq){
+	double K = tan(M_PI * fmin(fmax(freq / (double)rate, 1e-6), 0.4999));
+	for (int k = 0; k < order / 2; k++){
+		double d1 = 2.0 * sin(M_PI * (2 * k + 1) / (2.0 * order)); // 1 / Q
+		sf_biquad_state_st *s = &chain->sections[chain->size++];
+		if (type == SF_BIQUAD_LOWPASS)
+			design_section(s, K, 1.0, 0.0, 0.0, d1, 1.0);
+		else if (type == SF_BIQUAD_HIGHPASS)
+			design_section(s, K, 0.0, 0.0, 1.0, d1, 1.0);
+		else // allpass
+			design_section(s, K, 1.0, -d1, 1.0, d1, 1.0);
+	}
+	if (order % 2){
+		// first order section, where the prototype is 1 / (1 + s) for the lowpass
+		sf_biquad_state_st *s = &chain->sections[chain->size++];
+		if (type == SF_BIQUAD_LOWPASS)
+			design_section1(s, K, 1.0, 0.0);
+		else if (type == SF_BIQUAD_HIGHPASS)
+			design_section1(s, K, 0.0, 1.0);
+		else
+			design_section1(s, K, 1.0, -1.0);
+	}
+}
+
+static inline int butterworth_sections(int order){
+	return (order + 1) / 2;
+}
+
+bool sf_butterworth(sf_biquad_chain_st *chain, sf_biquad_type type, int order, int rate,
+	float freq){
+	if (order < 1 || (type != SF_BIQUAD_LOWPASS && type != SF_BIQUAD_HIGHPASS &&
+		type != SF_BIQUAD_ALLPASS) ||
+		chain->size + butterworth_sections(order) > SF_BIQUAD_CHAIN_MAX)
+		return false;
+	butterworth(chain, type, order, rate, freq);
+	return true;
+}
+
+// a Linkwitz-Riley filter is two Butterworth filters of half the order in a row, which is -6dB at
+// the cutoff instead of -3dB, so the lowpass and highpass add back up to a flat response
+//
+// the sum is only flat if the highpass is flipped upside down when the Butterworth order is odd
+// (LR2, LR6, etc), so the highpass does that itself, to keep the bands easy to use
+bool sf_linkwitzriley(sf_biquad_chain_st *chain, sf_biquad_type type, int order, int rate,
+	float freq){
+	if (order < 2 || order % 2 || (type != SF_BIQUAD_LOWPASS && type != SF_BIQUAD_HIGHPASS) ||
+		chain->size + 2 * butterworth_sections(order / 2) > SF_BIQUAD_CHAIN_MAX)
+		return false;
+	int first = chain->size;
+	butterworth(chain, type, order / 2, rate, freq);
+	butterworth(chain, type, order / 2, rate, freq);
+	if (type == SF_BIQUAD_HIGHPASS && (order / 2) % 2){
+		sf_biquad_state_st *s = &chain->sections[first];
+		s->b0 = -s->b0;
+		s->b1 = -s->b1;
+		s->b2 = -s->b2;
+	}
+	return true;
+}
+
+// the design cache is a simple hash table, where each setting can only live in one slot, and a new
+// setting just overwrites whatever was in its slot before
+void sf_biquad_cache_init(sf_biquad_cache_st *cache){
+	for (int i = 0; i < SF_BIQUAD_CACHE_SIZE; i++)
+		cache->entries[i].used = false;
+}
+
+static inline uint32_t cache_hash(sf_biquad_type type, int rate, float freq, float Q, float gain,
+	bool fast){
+	// scramble each part of the key with a different odd multiplier, then mix the high bits of the
+	// combination back down into the low bits (the finalizer from MurmurHash3)
+	uint32_t h =
+		((uint32_t)type        * 0x9E3779B1u) ^
+		((uint32_t)rate        * 0x85EBCA77u) ^
+		(fast_float2bits(freq) * 0xC2B2AE3Du) ^
+		(fast_float2bits(Q)    * 0x27D4EB2Fu) ^
+		(fast_float2bits(gain) * 0x165667B1u) ^
+		((uint32_t)fast        * 0xD3A2646Du);
+	h ^= h >> 16;
+	h *= 0x85EBCA6Bu;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35u;
+	h ^= h >> 16;
+	return h;
+}
+
+void sf_biquad_cache_design(sf_biquad_cache_st *cache, sf_biquad_state_st *state,
+	sf_biquad_type type, int rate, float freq, float Q, float gain, bool fast){
+	// only the peaking and shelf filters use the gain, so the others ignore it in the key as well,
+	// and settings that only differ by an unused gain share a slot
+	if (type != SF_BIQUAD_PEAKING && type != SF_BIQUAD_LOWSHELF && type != SF_BIQUAD_HIGHSHELF)
+		gain = 0.0f;
+	sf_biquad_cache_entry_st *e =
+		&cache->entries[cache_hash(type, rate, freq, Q, gain, fast) % SF_BIQUAD_CACHE_SIZE];
+	if (e->used && e->type == type && e->rate == rate && e->freq == freq && e->Q == Q &&
+		e->gain == gain && e->fast == fast){
+		// cache hit, so skip the math entirely
+		state_reset(state);
+		state->b0 = e->b0;
+		state->b1 = e->b1;
+		state->b2 = e->b2;
+		state->a1 = e->a1;
+		state->a2 = e->a2;
+		return;
+	}
+
+	// cache miss, so perform the design and remember it
+	design(state, type, rate, freq, Q, gain, fast);
+	e->used = true;
+	e->fast = fast;
+	e->type = type;
+	e->rate = rate;
+	e->freq = freq;
+	e->Q    = Q;
+	e->gain = gain;
+	e->b0   = state->b0;
+	e->b1   = state->b1;
+	e->b2   = state->b2;
+	e->a1   = state->a1;
+	e->a2   = state->a2;
+}
@@ -9,6 +9,7 @@
 #define SNDFILTER_BIQUAD__H
 
 #include "snd.h"
+#include <stdint.h>
 
 // biquad filtering is a technique used to perform a variety of sound filters
 //
@@ -51,9 +52,337 @@ void sf_allpass  (sf_biquad_state_st *state, int rate, float freq, float Q);
 void sf_lowshelf (sf_biquad_state_st *state, int rate, float freq, float Q, float gain);
 void sf_highshelf(sf_biquad_state_st *state, int rate, float freq, float Q, float gain);
 
+// the filters above, for the functions below that can design any type of filter
+typedef enum {
+	SF_BIQUAD_LOWPASS,
+	SF_BIQUAD_HIGHPASS,
+	SF_BIQUAD_BANDPASS,
+	SF_BIQUAD_NOTCH,
+	SF_BIQUAD_PEAKING,
+	SF_BIQUAD_ALLPASS,
+	SF_BIQUAD_LOWSHELF,
+	SF_BIQUAD_HIGHSHELF
+} sf_biquad_type;
+
+// initialize an sf_biquad_state_st structure based on the type of filter, which is the same as
+// calling the matching function above
+// for lowpass and highpass filters, `Q` is the resonance, and `gain` is ignored by the filters that
+// don't have a gain parameter
+void sf_biquad_design(sf_biquad_state_st *state, sf_biquad_type type, int rate, float freq,
+	float Q, float gain);
+
+// same as sf_biquad_design, but uses fast approximations of sinf/cosf/powf instead of calling the
+// math library, which is useful when changing filter settings very often (like automating a cutoff
+// once per chunk on a lot of voices)
+// the coefficients stay within about 1e-5 of the ones from sf_biquad_design
+void sf_biquad_design_fast(sf_biquad_state_st *state, sf_biquad_type type, int rate, float freq,
+	float Q, float gain);
+
+// design cache
+//
+// an sf_biquad_cache_st remembers the coefficients of recent designs, so that asking for the same
+// settings again skips the math entirely -- this is a small table where each setting has one slot
+// it can live in, so a new setting simply replaces the old one sharing its slot
+
+// number of slots in the cache
+#define SF_BIQUAD_CACHE_SIZE   64
+
+typedef struct {
+	bool used;
+	bool fast;
+	sf_biquad_type type;
+	int rate;
+	float freq;
+	float Q;
+	float gain;
+	float b0;
+	float b1;
+	float b2;
+	float a1;
+	float a2;
+} sf_biquad_cache_entry_st;
+
+typedef struct {
+	sf_biquad_cache_entry_st entries[SF_BIQUAD_CACHE_SIZE];
+} sf_biquad_cache_st;
+
+// initialize an empty cache
+void sf_biquad_cache_init(sf_biquad_cache_st *cache);
+
+// same as sf_biquad_design (or sf_biquad_design_fast if `fast` is true), but looks up the settings
+// in the cache first
+void sf_biquad_cache_design(sf_biquad_cache_st *cache, sf_biquad_state_st *state,
+	sf_biquad_type type, int rate, float freq, float Q, float gain, bool fast);
+
 // this function will process the input sound based on the state passed
 // the input and output buffers should be the same size
+// if the compiler supports SIMD, both channels are processed at once, with results matching the
+// scalar version (see biquad.c for the exact tolerance)
 void sf_biquad_process(sf_biquad_state_st *state, int size, sf_sample_st *input,
 	sf_sample_st *output);
 
+// alternative to sf_biquad_process for long offline sounds
+//
+// instead of computing one output sample at a time, this rewrites the filter as a block recurrence
+// that computes 4 output samples at once from the 4 input samples and the last two outputs, so
+// the serial dependency is only carried once per 4 samples instead of once per sample
+//
+// the results are mathematically the same as sf_biquad_process, but the floating point operations
+// happen in a different order, so they differ by rounding -- typically around 1e-6 relative to the
+// peak of the signal, growing to around 1e-3 for very low cutoffs with a lot of resonance, where
+// the poles sit right next to the unit circle (use sf_biquad_process for those)
+//
+// the state structure is updated the same way, so the two functions can be mixed freely
+void sf_biquad_process_block(sf_biquad_state_st *state, int size, sf_sample_st *input,
+	sf_sample_st *output);
+
+// cascaded biquads
+//
+// EQs are usually built from several biquads in series, and an sf_biquad_chain_st holds all of the
+// sections so they can be processed together
+//
+// for example, for a two band EQ over a stream with 128 samples per chunk, you would do:
+//
+//   sf_biquad_chain_st eq;
+//   sf_biquad_chain_init(&eq);
+//   sf_lowshelf(sf_biquad_chain_add(&eq), 44100, 200, 1, 3);
+//   sf_peaking (sf_biquad_chain_add(&eq), 44100, 2000, 1, -6);
+//
+//   for each 128 length sample:
+//     sf_biquad_chain_process(&eq, 128, input, output);
+//
+// the output is identical to calling sf_biquad_process once per section, but instead of streaming
+// the entire sound through memory once per section, the chain works on small blocks of samples
+// that stay in the cache while every section runs over them
+
+// maximum number of sections in a chain
+#define SF_BIQUAD_CHAIN_MAX    32
+
+// number of samples each section processes before moving on to the next section
+#define SF_BIQUAD_CHAIN_BLOCK  256
+
+typedef struct {
+	int size; // number of sections used
+	sf_biquad_state_st sections[SF_BIQUAD_CHAIN_MAX];
+} sf_biquad_chain_st;
+
+// initialize an empty chain
+void sf_biquad_chain_init(sf_biquad_chain_st *chain);
+
+// append a section to the end of the chain, and return it so it can be initialized by one of the
+// filter functions above (returns NULL if the chain is full)
+sf_biquad_state_st *sf_biquad_chain_add(sf_biquad_chain_st *chain);
+
+// process the input sound through every section of the chain in a single pass
+// the input and output buffers should be the same size, and can be the same buffer
+void sf_biquad_chain_process(sf_biquad_chain_st *chain, int size, sf_sample_st *input,
+	sf_sample_st *output);
+
+// higher order filters
+//
+// these functions design steeper lowpass and highpass filters by appending several sections to the
+// end of a chain, for example, an 8th order Butterworth lowpass at 1000Hz:
+//
+//   sf_biquad_chain_st lp;
+//   sf_biquad_chain_init(&lp);
+//   sf_butterworth(&lp, SF_BIQUAD_LOWPASS, 8, 44100, 1000);
+//
+// the number of sections is half the order (rounding up), so the example above appends 4 sections
+//
+// unlike sf_lowpass and friends, `freq` is the actual cutoff in Hz (those place their cutoff at
+// twice the value given; see sf_biquad_response)
+//
+// the functions return false, without changing the chain, if the order isn't supported or the
+// chain doesn't have room for all of the sections
+
+// Butterworth filters are as flat as possible in the passband, and are -3dB at the cutoff
+// `type` can be SF_BIQUAD_LOWPASS, SF_BIQUAD_HIGHPASS, or SF_BIQUAD_ALLPASS, where the allpass
+// has the same phase response as a Linkwitz-Riley lowpass and highpass of twice the order added
+// together
+bool sf_butterworth(sf_biquad_chain_st *chain, sf_biquad_type type, int order, int rate,
+	float freq);
+
+// Linkwitz-Riley filters are used for crossovers: they're -6dB at the cutoff, so a lowpass and a
+// highpass of the same order and cutoff add back up to a flat response (see crossover.h)
+// `type` can be SF_BIQUAD_LOWPASS or SF_BIQUAD_HIGHPASS, and `order` must be even (LR4 is 4, etc)
+bool sf_linkwitzriley(sf_biquad_chain_st *chain, sf_biquad_type type, int order, int rate,
+	float freq);
+
+// offline processing across several threads
+//
+// for long sounds that are already entirely in memory, the sound can be split into pieces that are
+// processed at the same time on separate threads
+//
+// a biquad depends on everything that came before it, but the influence of old samples decays at a
+// rate set by the filter's poles, so each piece first runs the filter over a stretch of the samples
+// before it (the warm-up) to settle into nearly the same state the serial version would have
+//
+// the warm-up is chosen so that the leftover difference is below 1e-7 of the signal level, which is
+// below the resolution of a float, so what remains is rounding: the result is as close to the exact
+// answer as sf_biquad_process is, but the two round differently -- around 1e-6 relative to the
+// peak of the signal for most filters, and around 1e-4 for very low cutoffs (below 100Hz or so),
+// where the rounding of sf_biquad_process itself gets amplified by the filter
+//
+// `threads` is the number of threads to use, or 0 to use one per CPU core; short sounds (less than
+// 16384 samples per thread), and filters that never settle, are processed on the calling thread
+//
+// the threads are pthreads, so on systems without them (or if the library is compiled with
+// SF_NO_THREADS defined), the whole sound is processed on the calling thread, the same as
+// sf_biquad_process
+//
+// the state is updated the same way as sf_biquad_process, so processing can continue afterwards
+void sf_biquad_process_parallel(sf_biquad_state_st *state, int size, sf_sample_st *input,
+	sf_sample_st *output, int threads);
+
+// returns the number of samples it takes for a filter to forget its saved samples, to within
+// `tolerance` of the signal level (for example, 1e-7 for about -140dB), or -1 if the filter never
+// settles because it's unstable
+int sf_biquad_warmup(const sf_biquad_state_st *state, float tolerance);
+
+// zero-phase filtering
+//
+// for offline work (like mastering), a sound can be filtered forwards and then backwards through
+// the same chain, which cancels out the phase shift of the filters -- every frequency comes out
+// time aligned, and the magnitude response is applied twice (so a 3dB boost becomes a 6dB boost)
+//
+// the ends of the sound are padded the same way as filtfilt from SciPy or MATLAB, so that the
+// filters don't ring from starting and stopping abruptly
+//
+// a single biquad is just a chain with one section:
+//
+//   sf_biquad_chain_st eq;
+//   sf_biquad_chain_init(&eq);
+//   sf_peaking(sf_biquad_chain_add(&eq), 44100, 2000, 1, 3);
+//   sf_biquad_filtfilt(&eq, size, input, output);
+//
+// the saved samples in the chain aren't used or changed, since the whole sound is processed at once
+// the input and output buffers should be the same size, and can be the same buffer
+void sf_biquad_filtfilt(const sf_biquad_chain_st *chain, int size, sf_sample_st *input,
+	sf_sample_st *output);
+
+// same as sf_biquad_filtfilt, but each pass is split across several threads, the same way as
+// sf_biquad_process_parallel (`threads` is 0 to use one thread per CPU core)
+void sf_biquad_filtfilt_parallel(const sf_biquad_chain_st *chain, int size, sf_sample_st *input,
+	sf_sample_st *output, int threads);
+
+// frequency response
+//
+// these functions calculate how a filter changes the sound at each of the frequencies (in Hz) in
+// `freqs`, which is useful for drawing EQ curves, or fitting filters to a target curve
+//
+// for each frequency, `mag` receives the magnitude of the response (1 is unchanged, 2 is twice as
+// loud, etc), and `phase` receives the phase shift in radians, between -pi and pi -- either one can
+// be NULL if it isn't needed
+//
+// `rate` is the sample rate the filter runs at, and the frequencies are the actual frequencies in
+// the sound, so they should be between 0 and rate/2
+//
+// the magnitude is accurate to around 1e-6 (relative), and the phase to around 1e-5 radians, even
+// for very low cutoffs and very deep cuts
+void sf_biquad_response(const sf_biquad_state_st *state, int rate, int count, const float *freqs,
+	float *mag, float *phase);
+
+// the combined response of every section of a chain
+void sf_biquad_chain_response(const sf_biquad_chain_st *chain, int rate, int count,
+	const float *freqs, float *mag, float *phase);
+
+// banks of independent biquads
+//
+// when a lot of unrelated sounds each need their own biquad (one filter per voice, for example),
+// an sf_biquad_bank_st holds up to SF_BIQUAD_BANK_MAX filters in structure-of-arrays form, so that
+// several streams can be processed together in the lanes of a SIMD vector
+//
+// each stream has its own coefficients and its own input/output buffers:
+//
+//   sf_biquad_state_st bq;
+//   sf_biquad_bank_st bank;
+//   sf_biquad_bank_init(&bank, voices);
+//   for each voice i:
+//     sf_lowpass(&bq, 44100, cutoff[i], 0);
+//     sf_biquad_bank_set(&bank, i, &bq);
+//
+//   for each 128 length sample:
+//     sf_biquad_bank_process(&bank, 128, inputs, outputs);
+//
+// where inputs[i] and outputs[i] point to the buffers for voice i
+//
+// for mono streams, only the L channel is needed; the R channel is processed the same way
+
+// maximum number of streams in a bank
+#define SF_BIQUAD_BANK_MAX     16
+
+typedef struct {
+	int size; // number of streams
+	float b0[SF_BIQUAD_BANK_MAX];
+	float b1[SF_BIQUAD_BANK_MAX];
+	float b2[SF_BIQUAD_BANK_MAX];
+	float a1[SF_BIQUAD_BANK_MAX];
+	float a2[SF_BIQUAD_BANK_MAX];
+	float xn1L[SF_BIQUAD_BANK_MAX], xn1R[SF_BIQUAD_BANK_MAX];
+	float xn2L[SF_BIQUAD_BANK_MAX], xn2R[SF_BIQUAD_BANK_MAX];
+	float yn1L[SF_BIQUAD_BANK_MAX], yn1R[SF_BIQUAD_BANK_MAX];
+	float yn2L[SF_BIQUAD_BANK_MAX], yn2R[SF_BIQUAD_BANK_MAX];
+} sf_biquad_bank_st;
+
+// initialize a bank with `size` streams that all pass their input through unchanged
+void sf_biquad_bank_init(sf_biquad_bank_st *bank, int size);
+
+// copy the coefficients and the saved samples of a biquad into one stream of the bank
+void sf_biquad_bank_set(sf_biquad_bank_st *bank, int stream, const sf_biquad_state_st *state);
+
+// copy one stream of the bank back out into a biquad state
+void sf_biquad_bank_get(const sf_biquad_bank_st *bank, int stream, sf_biquad_state_st *state);
+
+// process `size` samples of every stream in the bank
+// input[i] and output[i] are the buffers for stream i, and can be the same buffer
+void sf_biquad_bank_process(sf_biquad_bank_st *bank, int size, sf_sample_st **input,
+	sf_sample_st **output);
+
+// fixed point biquads
+//
+// for 16-bit PCM (like the samples inside a WAV file), an sf_biquad_fixed_st runs the filter
+// directly on the integer samples, using integer math, so the sound never needs to be converted to
+// floating point and back
+//
+// the filter is designed as usual, then converted:
+//
+//   sf_biquad_state_st bq;
+//   sf_biquad_fixed_st fx;
+//   sf_lowpass(&bq, 44100, 440, 1);
+//   sf_biquad_fixed_init(&fx, &bq);
+//
+//   for each 128 length sample:
+//     sf_biquad_fixed_process(&fx, 128, input, output);
+//
+// where input and output hold 128 stereo samples, interleaved (L, R, L, R, ...)
+//
+// the rounding error of the integer math is fed back through the filter, which cancels out the
+// boost the filter would otherwise give it (a lot, for very low or very high cutoffs), so the
+// result stays within about half an LSB of the exact result at any cutoff (it's the exact result,
+// rounded), which is closer than the floating point version gets after converting back to 16 bits;
+// the output is clipped at the limits of 16 bits instead of wrapping around
+
+typedef struct {
+	int32_t b0; // coefficients, scaled by 2^shift
+	int32_t b1;
+	int32_t b2;
+	int32_t a1;
+	int32_t a2;
+	int shift;
+	int32_t xn1L, xn1R;
+	int32_t xn2L, xn2R;
+	int32_t yn1L, yn1R;
+	int32_t yn2L, yn2R;
+	int64_t en1L, en1R; // the rounding error of the last two samples, which is fed back in
+	int64_t en2L, en2R;
+} sf_biquad_fixed_st;
+
+// convert the coefficients of a biquad to fixed point, and clear the saved samples
+void sf_biquad_fixed_init(sf_biquad_fixed_st *fixed, const sf_biquad_state_st *state);
+
+// process `size` stereo samples of interleaved 16-bit PCM
+// the input and output buffers should be the same size, and can be the same buffer
+void sf_biquad_fixed_process(sf_biquad_fixed_st *state, int size, const int16_t *input,
+	int16_t *output);
+
 #endif // SNDFILTER_BIQUAD__H
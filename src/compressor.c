@@ -3,18 +3,31 @@
 // Project Home: https://github.com/voidqk/sndfilter
 
 #include "compressor.h"
+#include "fastmath.h"
+#include "simd.h"
+#include "denormal.h"
+#include "mem.h"
 #include <math.h>
 #include <string.h>
 
+// the processing loop is copied into a version for each SPU size and for the fast math, but it's
+// too big for the compiler to do that by itself, so it's forced to with clang and gcc (other
+// compilers end up with one general version)
+#if defined(__GNUC__) || defined(__clang__)
+#	define COMPRESSOR_INLINE static inline __attribute__((always_inline))
+#else
+#	define COMPRESSOR_INLINE static inline
+#endif
+
 // core algorithm extracted from Chromium source, DynamicsCompressorKernel.cpp, here:
 //   https://git.io/v1uSK
 //
 // changed a few things though in an attempt to simplify the curves and algorithm, and also included
 // a pregain so that samples can be scaled up then compressed
 
-void sf_defaultcomp(sf_compressor_state_st *state, int rate){
+bool sf_defaultcomp(sf_compressor_state_st *state, int rate){
 	// sane defaults
-	sf_advancecomp(state, rate,
+	return sf_advancecomp(state, rate,
 		  0.000f, // pregain
 		-24.000f, // threshold
 		 30.000f, // knee
@@ -27,70 +40,154 @@ void sf_defaultcomp(sf_compressor_state_st *state, int rate){
 		  0.420f, // releasezone3
 		  0.980f, // releasezone4
 		  0.000f, // postgain
-		  1.000f  // wet
+		  1.000f, // wet
+		SF_COMPRESSOR_SPU
 	);
 }
 
-void sf_simplecomp(sf_compressor_state_st *state, int rate, float pregain, float threshold,
+bool sf_simplecomp(sf_compressor_state_st *state, int rate, float pregain, float threshold,
 	float knee, float ratio, float attack, float release){
 	// sane defaults
-	sf_advancecomp(state, rate, pregain, threshold, knee, ratio, attack, release,
+	return sf_advancecomp(state, rate, pregain, threshold, knee, ratio, attack, release,
 		0.006f, // predelay
 		0.090f, // releasezone1
 		0.160f, // releasezone2
 		0.420f, // releasezone3
 		0.980f, // releasezone4
 		0.000f, // postgain
-		1.000f  // wet
+		1.000f, // wet
+		SF_COMPRESSOR_SPU
 	);
 }
 
-static inline float db2lin(float db){ // dB to linear
-	return powf(10.0f, 0.05f * db);
+// the helpers below are shared by the normal and the fast versions of the API; the `fast` flag
+// picks which math functions are used (see fastmath.h for the approximations)
+static inline float db2lin(float db, bool fast){ // dB to linear
+	return fast ? fast_pow10f(0.05f * db) : powf(10.0f, 0.05f * db);
 }
 
-static inline float lin2db(float lin){ // linear to dB
-	return 20.0f * log10f(lin);
+static inline float lin2db(float lin, bool fast){ // linear to dB
+	return 20.0f * (fast ? fast_log10f(lin) : log10f(lin));
+}
+
+// the fast version also replaces the math that runs for every sample with the cheaper
+// approximations below, which only need to keep the gain accurate to a tiny fraction of a dB
+//
+// 2^x for x between -126 and 127 (anything outside of that is clamped)
+// max relative error: 2.1e-7 (1.8e-6dB), and exactly 1 at 0
+static inline float sample_exp2(float x){
+	x = x < -126.0f ? -126.0f : (x > 127.0f ? 127.0f : x);
+	// split x into a whole number i and a fraction f between -0.5 and 0.5, by rounding with the
+	// 1.5 * 2^23 trick, and use a polynomial for 2^f
+	float r = (x + 12582912.0f) - 12582912.0f;
+	float f = x - r;
+	float p = 1.0f + f * (0.693147182f + f * (0.240223482f + f * (0.0555033311f +
+		f * (0.00966637302f + f * 0.00134004257f))));
+	return p * fast_bits2float((uint32_t)((int)r + 127) << 23);
+}
+
+// log2(x) for positive, finite x
+// max absolute error: 4.5e-6 (2.7e-5dB), and max relative error 9e-6 near 1
+static inline float sample_log2(float x){
+	// split x into 2^e * m, with m between sqrt(1/2) and sqrt(2), by measuring the exponent from
+	// sqrt(1/2) instead of 1, and use a polynomial for log2(m) = t * p(t), where t = m - 1
+	int32_t bits = (int32_t)fast_float2bits(x);
+	int32_t e = (bits - 0x3F3504F3) >> 23;
+	float t = fast_bits2float((uint32_t)(bits - (e << 23))) - 1.0f;
+	float p = 1.44270301f + t * (-0.721223474f + t * (0.47967124f + t * (-0.365855753f +
+		t * (0.319826633f + t * -0.211530432f))));
+	return (float)e + t * p;
+}
+
+static inline float sample_db2lin(float db, bool fast){
+	return fast ? sample_exp2(db * 0.166096405f) : db2lin(db, false); // 10^(db/20)
+}
+
+static inline float sample_lin2db(float lin, bool fast){
+	return fast ? sample_log2(lin) * 6.02059991f : lin2db(lin, false); // 20 * log10(2)
+}
+
+static inline float sample_exp(float x, bool fast){
+	return fast ? sample_exp2(x * 1.44269504f) : expf(x); // e^x = 2^(x * log2(e))
 }
 
 // for more information on the knee curve, check out the compressor-curve.html demo + source code
 // included in this repo
-static inline float kneecurve(float x, float k, float linearthreshold){
-	return linearthreshold + (1.0f - expf(-k * (x - linearthreshold))) / k;
+static inline float kneecurve(float x, float k, float linearthreshold, bool fast){
+	return linearthreshold + (1.0f - sample_exp(-k * (x - linearthreshold), fast)) / k;
 }
 
 static inline float kneeslope(float x, float k, float linearthreshold){
 	return k * x / ((k * linearthreshold + 1.0f) * expf(k * (x - linearthreshold)) - 1);
 }
 
+// the curve above the threshold, which also keeps going below it (see the curve table)
+static inline float compcurveover(float x, float k, float slope, float linearthreshold,
+	float linearthresholdknee, float threshold, float knee, float kneedboffset, bool fast){
+	if (knee <= 0.0f) // no knee in curve
+		return sample_db2lin(threshold + slope * (sample_lin2db(x, fast) - threshold), fast);
+	if (x < linearthresholdknee)
+		return kneecurve(x, k, linearthreshold, fast);
+	return sample_db2lin(kneedboffset + slope * (sample_lin2db(x, fast) - threshold - knee), fast);
+}
+
 static inline float compcurve(float x, float k, float slope, float linearthreshold,
-	float linearthresholdknee, float threshold, float knee, float kneedboffset){
+	float linearthresholdknee, float threshold, float knee, float kneedboffset, bool fast){
 	if (x < linearthreshold)
 		return x;
-	if (knee <= 0.0f) // no knee in curve
-		return db2lin(threshold + slope * (lin2db(x) - threshold));
-	if (x < linearthresholdknee)
-		return kneecurve(x, k, linearthreshold);
-	return db2lin(kneedboffset + slope * (lin2db(x) - threshold - knee));
+	return compcurveover(x, k, slope, linearthreshold, linearthresholdknee, threshold, knee,
+		kneedboffset, fast);
+}
+
+// the curve table is indexed by the bits of the input level: the exponent picks the octave, and
+// the top CURVEBITS bits of the mantissa pick the entry inside of it, so each entry is a straight
+// line from one level to the next, and the rest of the mantissa is how far along that line to go
+#define CURVEFRACBITS  (23 - SF_COMPRESSOR_CURVEBITS)
+
+// attenuation of the curve at input level x, for x between 2^CURVEMIN and 2^CURVEMAX
+static inline float curvelookup(const float *curve, float x){
+	uint32_t bits = fast_float2bits(x) - ((uint32_t)(127 + SF_COMPRESSOR_CURVEMIN) << 23);
+	uint32_t i = bits >> CURVEFRACBITS;
+	float f = (float)(bits & ((1 << CURVEFRACBITS) - 1)) * (1.0f / (1 << CURVEFRACBITS));
+	return curve[i] + (curve[i + 1] - curve[i]) * f;
 }
 
 // this is the main initialization function
 // it does a bunch of pre-calculation so that the inner loop of signal processing is fast
-void sf_advancecomp(sf_compressor_state_st *state, int rate, float pregain, float threshold,
+bool sf_advancecomp(sf_compressor_state_st *state, int rate, float pregain, float threshold,
 	float knee, float ratio, float attack, float release, float predelay, float releasezone1,
-	float releasezone2, float releasezone3, float releasezone4, float postgain, float wet){
-
-	// setup the predelay buffer
+	float releasezone2, float releasezone3, float releasezone4, float postgain, float wet, int spu){
+	// the envelope is worked out four samples at a time, so the chunks must split evenly
+	if (spu < 4 || spu > SF_COMPRESSOR_MAXSPU || (spu & 3) != 0)
+		return false;
+
+	// setup the predelay buffer, which is up to one second long
+	//
+	// the sound is delayed by delaybufsize - 1 samples, but the buffer itself is rounded up to a
+	// power of 2, so the positions can wrap around with a mask instead of a division; the read
+	// position just trails the write position by the delay
 	int delaybufsize = rate * predelay;
 	if (delaybufsize < 1)
 		delaybufsize = 1;
-	else if (delaybufsize > SF_COMPRESSOR_MAXDELAY)
-		delaybufsize = SF_COMPRESSOR_MAXDELAY;
-        memset(state->delaybuf, 0, sizeof(sf_sample_st) * delaybufsize);
+	else if (delaybufsize > rate)
+		delaybufsize = rate;
+	int delaymask = 1;
+	while (delaymask < delaybufsize)
+		delaymask <<= 1;
+	delaymask--;
+	//
+	// the curve table (see below) comes out of the same allocation, right after the buffer, so a
+	// state stays small, and sf_compressor_free releases both
+	sf_sample_st *delaybuf = sf_malloc(sizeof(sf_sample_st) * (delaymask + 1) +
+		sizeof(float) * SF_COMPRESSOR_CURVESIZE);
+	if (delaybuf == NULL)
+		return false;
+	memset(delaybuf, 0, sizeof(sf_sample_st) * (delaymask + 1));
+	float *curve = (float *)&delaybuf[delaymask + 1];
 
 	// useful values
-	float linearpregain = db2lin(pregain);
-	float linearthreshold = db2lin(threshold);
+	float linearpregain = db2lin(pregain, false);
+	float linearthreshold = db2lin(threshold, false);
 	float slope = 1.0f / ratio;
 	float attacksamples = rate * attack;
 	float attacksamplesinv = 1.0f / attacksamples;
@@ -109,7 +206,7 @@ void sf_advancecomp(sf_compressor_state_st *state, int rate, float pregain, floa
 	float kneedboffset = 0.0f;
 	float linearthresholdknee = 0.0f;
 	if (knee > 0.0f){ // if a knee exists, search for a good k value
-		float xknee = db2lin(threshold + knee);
+		float xknee = db2lin(threshold + knee, false);
 		float mink = 0.1f;
 		float maxk = 10000.0f;
 		// search by comparing the knee slope at the current k guess, to the ideal slope
@@ -120,14 +217,27 @@ void sf_advancecomp(sf_compressor_state_st *state, int rate, float pregain, floa
 				mink = k;
 			k = sqrtf(mink * maxk);
 		}
-		kneedboffset = lin2db(kneecurve(xknee, k, linearthreshold));
-		linearthresholdknee = db2lin(threshold + knee);
+		kneedboffset = lin2db(kneecurve(xknee, k, linearthreshold, false), false);
+		linearthresholdknee = db2lin(threshold + knee, false);
+	}
+
+	// fill in the curve table with the attenuation at the level of each entry
+	//
+	// entries below the threshold hold the curve as it would continue below the threshold, instead
+	// of no attenuation, so that the line from the last entry under the threshold to the first
+	// entry over it follows the curve (the table is only used for levels over the threshold)
+	for (int i = 0; i < SF_COMPRESSOR_CURVESIZE; i++){
+		float x = ldexpf(1.0f + (float)(i & ((1 << SF_COMPRESSOR_CURVEBITS) - 1)) /
+			(1 << SF_COMPRESSOR_CURVEBITS),
+			SF_COMPRESSOR_CURVEMIN + (i >> SF_COMPRESSOR_CURVEBITS));
+		curve[i] = compcurveover(x, k, slope, linearthreshold, linearthresholdknee,
+			threshold, knee, kneedboffset, false) / x;
 	}
 
 	// calculate a master gain based on what sounds good
 	float fulllevel = compcurve(1.0f, k, slope, linearthreshold, linearthresholdknee,
-		threshold, knee, kneedboffset);
-	float mastergain = db2lin(postgain) * powf(1.0f / fulllevel, 0.6f);
+		threshold, knee, kneedboffset, false);
+	float mastergain = db2lin(postgain, false) * powf(1.0f / fulllevel, 0.6f);
 
 	// calculate the adaptive release curve parameters
 	// solve a,b,c,d in `y = a*x^3 + b*x^2 + c*x + d`
@@ -164,9 +274,22 @@ void sf_advancecomp(sf_compressor_state_st *state, int rate, float pregain, floa
 	state->detectoravg          = 0.0f;
 	state->compgain             = 1.0f;
 	state->maxcompdiffdb        = -1.0f;
+	state->spu                  = spu;
+	state->chunkpos             = 0;
 	state->delaybufsize         = delaybufsize;
+	state->delaymask            = delaymask;
 	state->delaywritepos        = 0;
-	state->delayreadpos         = delaybufsize > 1 ? 1 : 0;
+	state->delayreadpos         = (1 - delaybufsize) & delaymask;
+	state->delaybuf             = delaybuf;
+	state->curve                = curve;
+	return true;
+}
+
+void sf_compressor_free(sf_compressor_state_st *state){
+	// the curve table is part of the same allocation
+	sf_free(state->delaybuf);
+	state->delaybuf = NULL;
+	state->curve = NULL;
 }
 
 // for more information on the adaptive release curve, check out adaptive-release-curve.html demo +
@@ -192,123 +315,313 @@ static inline float fixf(float v, float def){
 	return v;
 }
 
-void sf_compressor_process(sf_compressor_state_st *state, int size, sf_sample_st *input,
-	sf_sample_st *output){
+// the attenuation that the curve asks for at an input level
+//
+// levels inside of the curve table are looked up without branching (the level is clamped into the
+// table, and the answer is picked afterwards), since the input jumps above and below the threshold
+// all the time, which makes branches impossible to predict; levels above the table are rare enough
+// that the exact curve is left behind a branch
+static inline float detectlevel(const sf_compressor_state_st *state, float inputmax,
+	float curvetop, bool fast){
+	float x = inputmax < curvetop ? inputmax : curvetop;
+	x = x < 0.0001f ? 0.0001f : x;
+	float attenuation = curvelookup(state->curve, x);
+	if (!(inputmax <= curvetop)){
+		attenuation = compcurve(inputmax, state->k, state->slope, state->linearthreshold,
+			state->linearthresholdknee, state->threshold, state->knee, state->kneedboffset,
+			fast) / inputmax;
+	}
+	return inputmax < 0.0001f || inputmax < state->linearthreshold ? 1.0f : attenuation;
+}
+
+// same as detectlevel, for four levels at once, which are stored to attenuation[0..3]
+static inline void detectlevel4(const sf_compressor_state_st *state, vec4 inputmax,
+	float curvetop, float *attenuation, bool fast){
+	vec4 x = vec4_select(vec4_lt(inputmax, vec4_set1(curvetop)), inputmax, vec4_set1(curvetop));
+	x = vec4_select(vec4_lt(x, vec4_set1(0.0001f)), vec4_set1(0.0001f), x);
+	// same as curvelookup, except the table entries are fetched one lane at a time
+	vec4i bits = vec4i_sub(vec4_bits(x), vec4i_set1((127 + SF_COMPRESSOR_CURVEMIN) << 23));
+	vec4i i = vec4i_sra(bits, CURVEFRACBITS);
+	vec4 f = vec4_mul(vec4i_tofloat(vec4i_and(bits, vec4i_set1((1 << CURVEFRACBITS) - 1))),
+		vec4_set1(1.0f / (1 << CURVEFRACBITS)));
+	const float *curve = state->curve;
+	vec4 c0 = vec4_set(curve[vec4i_get(i, 0)], curve[vec4i_get(i, 1)],
+		curve[vec4i_get(i, 2)], curve[vec4i_get(i, 3)]);
+	vec4 c1 = vec4_set(curve[vec4i_get(i, 0) + 1], curve[vec4i_get(i, 1) + 1],
+		curve[vec4i_get(i, 2) + 1], curve[vec4i_get(i, 3) + 1]);
+	vec4 att = vec4_add(c0, vec4_mul(vec4_sub(c1, c0), f));
+	att = vec4_select(vec4_lt(inputmax, vec4_set1(state->linearthreshold)), vec4_set1(1.0f), att);
+	att = vec4_select(vec4_lt(inputmax, vec4_set1(0.0001f)), vec4_set1(1.0f), att);
+	vec4_store(attenuation, att);
+	for (int n = 0; n < 4; n++){
+		if (!(vec4_get(inputmax, n) <= curvetop))
+			attenuation[n] = detectlevel(state, vec4_get(inputmax, n), curvetop, fast);
+	}
+}
+
+// the rate that the detector releases at, for a sample with the given attenuation
+static inline float releaserate(float attenuation, float satreleasesamplesinv, bool fast){
+	float attenuationdb = -sample_lin2db(attenuation, fast);
+	if (attenuationdb < 2.0f)
+		attenuationdb = 2.0f;
+	float dbpersample = attenuationdb * satreleasesamplesinv;
+	return sample_db2lin(dbpersample, fast) - 1.0f;
+}
+
+// sample_log2 and sample_exp2 for four values at once, which give exactly the same answers
+static inline vec4 sample_log2x4(vec4 x){
+	vec4i bits = vec4_bits(x);
+	vec4i e = vec4i_sra(vec4i_sub(bits, vec4i_set1(0x3F3504F3)), 23);
+	vec4 t = vec4_sub(vec4i_bits(vec4i_sub(bits, vec4i_shl(e, 23))), vec4_set1(1.0f));
+	vec4 p = vec4_add(vec4_set1(0.319826633f), vec4_mul(t, vec4_set1(-0.211530432f)));
+	p = vec4_add(vec4_set1(-0.365855753f), vec4_mul(t, p));
+	p = vec4_add(vec4_set1(0.47967124f), vec4_mul(t, p));
+	p = vec4_add(vec4_set1(-0.721223474f), vec4_mul(t, p));
+	p = vec4_add(vec4_set1(1.44270301f), vec4_mul(t, p));
+	return vec4_add(vec4i_tofloat(e), vec4_mul(t, p));
+}
+
+static inline vec4 sample_exp2x4(vec4 x){
+	x = vec4_select(vec4_lt(x, vec4_set1(-126.0f)), vec4_set1(-126.0f), x);
+	x = vec4_select(vec4_gt(x, vec4_set1(127.0f)), vec4_set1(127.0f), x);
+	vec4 r = vec4_round(x);
+	vec4 f = vec4_sub(x, r);
+	vec4 p = vec4_add(vec4_set1(0.00966637302f), vec4_mul(f, vec4_set1(0.00134004257f)));
+	p = vec4_add(vec4_set1(0.0555033311f), vec4_mul(f, p));
+	p = vec4_add(vec4_set1(0.240223482f), vec4_mul(f, p));
+	p = vec4_add(vec4_set1(0.693147182f), vec4_mul(f, p));
+	p = vec4_add(vec4_set1(1.0f), vec4_mul(f, p));
+	return vec4_mul(p, vec4i_bits(vec4i_shl(vec4i_add(vec4_toint(r), vec4i_set1(127)), 23)));
+}
+
+// same as releaserate with `fast` set, for four samples at once
+static inline vec4 releaserate4(vec4 attenuation, float satreleasesamplesinv){
+	vec4 attenuationdb = vec4_sub(vec4_set1(0.0f),
+		vec4_mul(sample_log2x4(attenuation), vec4_set1(6.02059991f)));
+	attenuationdb = vec4_select(vec4_lt(attenuationdb, vec4_set1(2.0f)), vec4_set1(2.0f),
+		attenuationdb);
+	vec4 dbpersample = vec4_mul(attenuationdb, vec4_set1(satreleasesamplesinv));
+	return vec4_sub(sample_exp2x4(vec4_mul(dbpersample, vec4_set1(0.166096405f))),
+		vec4_set1(1.0f));
+}
+
+// work out the attenuation of each sample of a chunk, along with the rate the detector would
+// release at if it ends up releasing on that sample
+//
+// none of this depends on the envelope, only on the input, so it runs as a separate pass ahead of
+// the envelope, four samples at a time, which leaves only the detector and gain recurrences for
+// the envelope pass
+static inline void detectchunk(const sf_compressor_state_st *state, int size,
+	const sf_sample_st *input, float *attenuation, float *release, bool fast){
+	// the largest level below 2^CURVEMAX, which is still inside of the table
+	float curvetop = nextafterf(ldexpf(1.0f, SF_COMPRESSOR_CURVEMAX), 0.0f);
+	float linearpregain = state->linearpregain;
+	float satreleasesamplesinv = state->satreleasesamplesinv;
+	vec4 pregain = vec4_set1(linearpregain);
+	int n = 0;
+	for (; n + 4 <= size; n += 4){
+		vec4 a = vec4_abs(vec4_mul(vec4_loadsamples(&input[n]), pregain));
+		vec4 b = vec4_abs(vec4_mul(vec4_loadsamples(&input[n + 2]), pregain));
+		vec4 L = vec4_set(vec4_get(a, 0), vec4_get(a, 2), vec4_get(b, 0), vec4_get(b, 2));
+		vec4 R = vec4_set(vec4_get(a, 1), vec4_get(a, 3), vec4_get(b, 1), vec4_get(b, 3));
+		vec4 inputmax = vec4_select(vec4_gt(L, R), L, R);
+		detectlevel4(state, inputmax, curvetop, &attenuation[n], fast);
+		// the normal version calls the math library one sample at a time
+		if (fast)
+			vec4_store(&release[n], releaserate4(vec4_load(&attenuation[n]), satreleasesamplesinv));
+		else{
+			for (int i = 0; i < 4; i++)
+				release[n + i] = releaserate(attenuation[n + i], satreleasesamplesinv, false);
+		}
+	}
+	for (; n < size; n++){
+		float inputL = absf(input[n].L * linearpregain);
+		float inputR = absf(input[n].R * linearpregain);
+		float inputmax = inputL > inputR ? inputL : inputR;
+		attenuation[n] = detectlevel(state, inputmax, curvetop, fast);
+		release[n] = releaserate(attenuation[n], satreleasesamplesinv, fast);
+	}
+}
+
+// sin(x * pi / 2) of each lane, for x between 0 and 1
+// max absolute error: 6e-7 (and since it's odd, the relative error near 0 is under 4e-6)
+static inline vec4 sin90x4(vec4 x){
+	vec4 x2 = vec4_mul(x, x);
+	vec4 p = vec4_add(vec4_set1(0.07943435f), vec4_mul(x2, vec4_set1(-0.0043331f)));
+	p = vec4_add(vec4_set1(-0.6458929f), vec4_mul(x2, p));
+	p = vec4_add(vec4_set1(1.570791f), vec4_mul(x2, p));
+	return vec4_mul(x, p);
+}
+
+// move the gain envelope forward over `size` samples (a multiple of 4), and work out the gain of
+// each sample before it's mixed with the dry sound (the sin of the envelope), returning where the
+// envelope ends up
+//
+// during a chunk, the envelope heads towards the same target at the same rate the whole time, so
+// instead of stepping it forward one sample at a time, each sample is calculated directly:
+//
+//   attacking:  compgain[n] = target + (compgain - target) * (1 - enveloperate)^n
+//   releasing:  compgain[n] = min(1, compgain * enveloperate^n)
+//
+// an attack never goes over 1 (it's between compgain and the target), so both are the same formula,
+// base + amount * q^n clamped to 1
+//
+// the powers of q are stepped forward four at a time in double precision: q is very close to 1
+// for long releases, and rounding q^4 to a float would push every chunk of a release the same way,
+// which adds up over thousands of chunks (stepping one sample at a time in float has the same
+// problem, but its rounding goes both ways and mostly cancels out)
+static inline float envelopechunk(float compgain, float scaleddesiredgain, float enveloperate,
+	int size, float *premixgain){
+	float base, amount;
+	double q;
+	if (enveloperate < 1){ // attack, reduce gain
+		base = scaleddesiredgain;
+		amount = compgain - scaleddesiredgain;
+		q = 1.0 - enveloperate;
+	}
+	else{ // release, increase gain
+		base = 0.0f;
+		amount = compgain;
+		q = enveloperate;
+	}
+	double q4 = (q * q) * (q * q);
+	double qn[4] = { q, q * q, q * q * q, q4 };
+	vec4 one = vec4_set1(1.0f);
+	vec4 gain = vec4_set1(compgain);
+	for (int n = 0; n < size; n += 4){
+		gain = vec4_add(vec4_set1(base), vec4_mul(vec4_set1(amount),
+			vec4_set((float)qn[0], (float)qn[1], (float)qn[2], (float)qn[3])));
+		gain = vec4_select(vec4_gt(gain, one), one, gain);
+		vec4_store(&premixgain[n], sin90x4(gain));
+		for (int i = 0; i < 4; i++)
+			qn[i] *= q4;
+	}
+	return vec4_get(gain, 3);
+}
+
+// at the start of each chunk, work out where the envelope is headed and how fast it gets there,
+// then fill in the gain of every sample of the chunk (`size` samples)
+//
+// the gain of the whole chunk is worked out up front, so it comes out the same even if the chunk
+// is split across calls
+static inline void startchunk(const sf_compressor_state_st *state, int size, float *detectoravg,
+	float *compgain, float *maxcompdiffdb, float *premixgains, bool fast){
+	float ang90inv = 2.0f / (float)M_PI;
+	float spacingdb = SF_COMPRESSOR_SPACINGDB;
+	float enveloperate;
+
+	*detectoravg = fixf(*detectoravg, 1.0f);
+	float desiredgain = *detectoravg;
+	float scaleddesiredgain = (fast ? fast_asinf(desiredgain) : asinf(desiredgain)) * ang90inv;
+	float compdiffdb = lin2db(*compgain / scaleddesiredgain, fast);
+
+	// calculate envelope rate based on whether we're attacking or releasing
+	if (compdiffdb < 0.0f){ // compgain < scaleddesiredgain, so we're releasing
+		compdiffdb = fixf(compdiffdb, -1.0f);
+		*maxcompdiffdb = -1; // reset for a future attack mode
+		// apply the adaptive release curve
+		// scale compdiffdb between 0-3
+		float x = (clampf(compdiffdb, -12.0f, 0.0f) + 12.0f) * 0.25f;
+		float releasesamples = adaptivereleasecurve(x, state->a, state->b, state->c, state->d);
+		enveloperate = db2lin(spacingdb / releasesamples, fast);
+	}
+	else{ // compresorgain > scaleddesiredgain, so we're attacking
+		compdiffdb = fixf(compdiffdb, 1.0f);
+		if (*maxcompdiffdb == -1 || *maxcompdiffdb < compdiffdb)
+			*maxcompdiffdb = compdiffdb;
+		float attenuate = *maxcompdiffdb;
+		if (attenuate < 0.5f)
+			attenuate = 0.5f;
+		if (fast) // x^y = 2^(y * log2(x))
+			enveloperate = 1.0f -
+				fast_exp2f(state->attacksamplesinv * fast_log2f(0.25f / attenuate));
+		else
+			enveloperate = 1.0f - powf(0.25f / attenuate, state->attacksamplesinv);
+	}
+
+	*compgain = envelopechunk(*compgain, scaleddesiredgain, enveloperate, size, premixgains);
+}
+
+// the processing is shared by sf_compressor_process and sf_compressor_process_fast, where `fast`
+// picks the math functions, and `samplesperchunk` is the state's SPU (this is inlined into each
+// version below with both of them known, so they don't cost anything)
+//
+// the detector listens to `key`, which is the input itself except for the sidechain versions, and
+// is run through `keyfilter` first if it isn't NULL
+COMPRESSOR_INLINE void compressor_run(sf_compressor_state_st *state, int size, sf_sample_st *input,
+	sf_sample_st *key, sf_biquad_state_st *keyfilter, sf_sample_st *output, int samplesperchunk,
+	bool fast){
+	uint64_t ftz = ftz_begin();
 
 	// pull out the state into local variables
 	float metergain            = state->metergain;
 	float meterrelease         = state->meterrelease;
-	float threshold            = state->threshold;
-	float knee                 = state->knee;
 	float linearpregain        = state->linearpregain;
-	float linearthreshold      = state->linearthreshold;
-	float slope                = state->slope;
-	float attacksamplesinv     = state->attacksamplesinv;
-	float satreleasesamplesinv = state->satreleasesamplesinv;
 	float wet                  = state->wet;
 	float dry                  = state->dry;
-	float k                    = state->k;
-	float kneedboffset         = state->kneedboffset;
-	float linearthresholdknee  = state->linearthresholdknee;
 	float mastergain           = state->mastergain;
-	float a                    = state->a;
-	float b                    = state->b;
-	float c                    = state->c;
-	float d                    = state->d;
 	float detectoravg          = state->detectoravg;
 	float compgain             = state->compgain;
 	float maxcompdiffdb        = state->maxcompdiffdb;
-	int delaybufsize           = state->delaybufsize;
+	int chunkpos               = state->chunkpos;
+	int delaymask              = state->delaymask;
 	int delaywritepos          = state->delaywritepos;
 	int delayreadpos           = state->delayreadpos;
 	sf_sample_st *delaybuf     = state->delaybuf;
+	float *premixgains         = state->premixgains;
 
-	int samplesperchunk = SF_COMPRESSOR_SPU;
-	int chunks = size / samplesperchunk;
-	float ang90 = (float)M_PI * 0.5f;
-	float ang90inv = 2.0f / (float)M_PI;
 	int samplepos = 0;
-	float spacingdb = SF_COMPRESSOR_SPACINGDB;
 
-	for (int ch = 0; ch < chunks; ch++){
-		detectoravg = fixf(detectoravg, 1.0f);
-		float desiredgain = detectoravg;
-		float scaleddesiredgain = asinf(desiredgain) * ang90inv;
-		float compdiffdb = lin2db(compgain / scaleddesiredgain);
-
-		// calculate envelope rate based on whether we're attacking or releasing
-		float enveloperate;
-		if (compdiffdb < 0.0f){ // compgain < scaleddesiredgain, so we're releasing
-			compdiffdb = fixf(compdiffdb, -1.0f);
-			maxcompdiffdb = -1; // reset for a future attack mode
-			// apply the adaptive release curve
-			// scale compdiffdb between 0-3
-			float x = (clampf(compdiffdb, -12.0f, 0.0f) + 12.0f) * 0.25f;
-			float releasesamples = adaptivereleasecurve(x, a, b, c, d);
-			enveloperate = db2lin(spacingdb / releasesamples);
-		}
-		else{ // compresorgain > scaleddesiredgain, so we're attacking
-			compdiffdb = fixf(compdiffdb, 1.0f);
-			if (maxcompdiffdb == -1 || maxcompdiffdb < compdiffdb)
-				maxcompdiffdb = compdiffdb;
-			float attenuate = maxcompdiffdb;
-			if (attenuate < 0.5f)
-				attenuate = 0.5f;
-			enveloperate = 1.0f - powf(0.25f / attenuate, attacksamplesinv);
+	while (samplepos < size){
+		// at the start of each chunk, work out where the envelope is headed for the chunk
+		if (chunkpos == 0)
+			startchunk(state, samplesperchunk, &detectoravg, &compgain, &maxcompdiffdb, premixgains,
+				fast);
+
+		// process as much of the chunk as there is input for, and pick it up again in the next call
+		// if the input runs out first
+		int len = samplesperchunk - chunkpos;
+		if (len > size - samplepos)
+			len = size - samplepos;
+		int chunkstart = chunkpos;
+		chunkpos += len;
+		if (chunkpos >= samplesperchunk)
+			chunkpos = 0;
+		float attenuations[SF_COMPRESSOR_MAXSPU], releaserates[SF_COMPRESSOR_MAXSPU];
+		sf_sample_st *detectinput = &key[samplepos];
+		sf_sample_st filteredkey[SF_COMPRESSOR_MAXSPU];
+		if (keyfilter){
+			// filter the key a piece at a time, right before it's needed, instead of filtering the
+			// whole key up front
+			sf_biquad_process(keyfilter, len, detectinput, filteredkey);
+			detectinput = filteredkey;
 		}
-
-		// process the chunk
-		for (int chi = 0; chi < samplesperchunk; chi++, samplepos++,
-			delayreadpos = (delayreadpos + 1) % delaybufsize,
-			delaywritepos = (delaywritepos + 1) % delaybufsize){
+		detectchunk(state, len, detectinput, attenuations, releaserates, fast);
+		for (int chi = 0; chi < len; chi++, samplepos++,
+			delayreadpos = (delayreadpos + 1) & delaymask,
+			delaywritepos = (delaywritepos + 1) & delaymask){
 
 			float inputL = input[samplepos].L * linearpregain;
 			float inputR = input[samplepos].R * linearpregain;
 			delaybuf[delaywritepos] = (sf_sample_st){ .L = inputL, .R = inputR };
 
-			inputL = absf(inputL);
-			inputR = absf(inputR);
-			float inputmax = inputL > inputR ? inputL : inputR;
-
-			float attenuation;
-			if (inputmax < 0.0001f)
-				attenuation = 1.0f;
-			else{
-				float inputcomp = compcurve(inputmax, k, slope, linearthreshold,
-					linearthresholdknee, threshold, knee, kneedboffset);
-				attenuation = inputcomp / inputmax;
-			}
+			float attenuation = attenuations[chi];
 
-			float rate;
-			if (attenuation > detectoravg){ // if releasing
-				float attenuationdb = -lin2db(attenuation);
-				if (attenuationdb < 2.0f)
-					attenuationdb = 2.0f;
-				float dbpersample = attenuationdb * satreleasesamplesinv;
-				rate = db2lin(dbpersample) - 1.0f;
-			}
-			else
-				rate = 1.0f;
+			float rate = 1.0f;
+			if (attenuation > detectoravg) // if releasing
+				rate = releaserates[chi];
 
 			detectoravg += (attenuation - detectoravg) * rate;
 			if (detectoravg > 1.0f)
 				detectoravg = 1.0f;
 			detectoravg = fixf(detectoravg, 1.0f);
 
-			if (enveloperate < 1) // attack, reduce gain
-				compgain += (scaleddesiredgain - compgain) * enveloperate;
-			else{ // release, increase gain
-				compgain *= enveloperate;
-				if (compgain > 1.0f)
-					compgain = 1.0f;
-			}
-
 			// the final gain value!
-			float premixgain = sinf(ang90 * compgain);
+			float premixgain = premixgains[chunkstart + chi];
 			float gain = dry + wet * mastergain * premixgain;
 
 			// calculate metering (not used in core algo, but used to output a meter if desired)
-			float premixgaindb = lin2db(premixgain);
+			float premixgaindb = sample_lin2db(premixgain, fast);
 			if (premixgaindb < metergain)
 				metergain = premixgaindb; // spike immediately
 			else
@@ -326,6 +639,281 @@ void sf_compressor_process(sf_compressor_state_st *state, int size, sf_sample_st
 	state->detectoravg   = detectoravg;
 	state->compgain      = compgain;
 	state->maxcompdiffdb = maxcompdiffdb;
+	state->chunkpos      = chunkpos;
 	state->delaywritepos = delaywritepos;
 	state->delayreadpos  = delayreadpos;
+	ftz_end(ftz);
+}
+
+// pick the version of the loop made for the state's SPU, where the chunk loops have a fixed length
+COMPRESSOR_INLINE void compressor_spu(sf_compressor_state_st *state, int size, sf_sample_st *input,
+	sf_sample_st *key, sf_biquad_state_st *keyfilter, sf_sample_st *output, bool fast){
+	switch (state->spu){
+		case   8: compressor_run(state, size, input, key, keyfilter, output,   8, fast); break;
+		case  16: compressor_run(state, size, input, key, keyfilter, output,  16, fast); break;
+		case  32: compressor_run(state, size, input, key, keyfilter, output,  32, fast); break;
+		case  64: compressor_run(state, size, input, key, keyfilter, output,  64, fast); break;
+		case 128: compressor_run(state, size, input, key, keyfilter, output, 128, fast); break;
+		default:
+			compressor_run(state, size, input, key, keyfilter, output, state->spu, fast);
+			break;
+	}
+}
+
+void sf_compressor_process(sf_compressor_state_st *state, int size, sf_sample_st *input,
+	sf_sample_st *output){
+	compressor_spu(state, size, input, input, NULL, output, false);
+}
+
+void sf_compressor_process_fast(sf_compressor_state_st *state, int size, sf_sample_st *input,
+	sf_sample_st *output){
+	compressor_spu(state, size, input, input, NULL, output, true);
+}
+
+void sf_compressor_process_sidechain(sf_compressor_state_st *state, int size, sf_sample_st *input,
+	sf_sample_st *sidechain, sf_sample_st *output, sf_biquad_state_st *keyfilter){
+	compressor_spu(state, size, input, sidechain, keyfilter, output, false);
+}
+
+void sf_compressor_process_sidechain_fast(sf_compressor_state_st *state, int size,
+	sf_sample_st *input, sf_sample_st *sidechain, sf_sample_st *output,
+	sf_biquad_state_st *keyfilter){
+	compressor_spu(state, size, input, sidechain, keyfilter, output, true);
+}
+
+// banks of compressors
+
+void sf_compressor_bank_init(sf_compressor_bank_st *bank, int size){
+	if (size < 0)
+		size = 0;
+	else if (size > SF_COMPRESSOR_BANK_MAX)
+		size = SF_COMPRESSOR_BANK_MAX;
+	memset(bank, 0, sizeof(sf_compressor_bank_st));
+	bank->size = size;
+}
+
+void sf_compressor_bank_set(sf_compressor_bank_st *bank, int stream,
+	sf_compressor_state_st *state){
+	if (stream < 0 || stream >= SF_COMPRESSOR_BANK_MAX)
+		return;
+	bank->state[stream]         = state;
+	bank->meterrelease[stream]  = state->meterrelease;
+	bank->metergain[stream]     = state->metergain;
+	bank->detectoravg[stream]   = state->detectoravg;
+	bank->compgain[stream]      = state->compgain;
+	bank->maxcompdiffdb[stream] = state->maxcompdiffdb;
+	bank->chunkpos[stream]      = state->chunkpos;
+	bank->delaywritepos[stream] = state->delaywritepos;
+	bank->delayreadpos[stream]  = state->delayreadpos;
+	memcpy(bank->premixgains[stream], state->premixgains, sizeof(float) * state->spu);
+}
+
+void sf_compressor_bank_get(sf_compressor_bank_st *bank, int stream){
+	if (stream < 0 || stream >= SF_COMPRESSOR_BANK_MAX || bank->state[stream] == NULL)
+		return;
+	sf_compressor_state_st *state = bank->state[stream];
+	state->metergain     = bank->metergain[stream];
+	state->detectoravg   = bank->detectoravg[stream];
+	state->compgain      = bank->compgain[stream];
+	state->maxcompdiffdb = bank->maxcompdiffdb[stream];
+	state->chunkpos      = bank->chunkpos[stream];
+	state->delaywritepos = bank->delaywritepos[stream];
+	state->delayreadpos  = bank->delayreadpos[stream];
+	memcpy(state->premixgains, bank->premixgains[stream], sizeof(float) * state->spu);
+}
+
+// process a group of up to 8 streams, one stream per vector lane, in `vecs` vectors of 4 lanes
+//
+// the work is split into three passes over each block of the sound:
+//
+//   1. the detector's input (the attenuation and release rate of each sample), one stream at a
+//      time, the same way compressor_run does it, four samples at a time
+//   2. the detector, the envelope and the meter, which depend on the sample before, with one
+//      stream per lane, so the streams overlap instead of waiting on each other
+//   3. the predelay and the final gain, one stream at a time again
+//
+// the second pass is held up by how long each step takes to finish before the next one can start,
+// rather than by the amount of math, so running two vectors side by side (8 streams) costs about
+// the same as running one
+//
+// every stream has its own SPU and is somewhere different in its chunk, so the second pass walks
+// through the block in stretches that end whenever any of the lanes reaches the end of a chunk,
+// and the lanes that start a new chunk work out their envelope for it, one at a time
+//
+// if the group has less streams than lanes, the extra lanes are left out of the first and third
+// passes, and just run along in the second one (with the gain of the first stream), without any
+// effect
+#define BANK_VECS   2
+#define BANK_LANES  (BANK_VECS * 4)
+#define BANK_BLOCK  256
+COMPRESSOR_INLINE void bank_group(sf_compressor_bank_st *bank, int first, int lanes, int vecs,
+	int size, sf_sample_st **input, sf_sample_st **output, bool fast){
+	sf_compressor_state_st **state = &bank->state[first];
+
+	// pull out the bank into local variables, in lane order
+	float meterrelease[BANK_LANES], metergain[BANK_LANES], detectoravg[BANK_LANES];
+	for (int i = 0; i < vecs * 4; i++){
+		int stream = first + (i < lanes ? i : 0);
+		meterrelease[i] = bank->meterrelease[stream];
+		metergain[i]    = bank->metergain[stream];
+		detectoravg[i]  = bank->detectoravg[stream];
+	}
+	float *compgain      = &bank->compgain[first];
+	float *maxcompdiffdb = &bank->maxcompdiffdb[first];
+	int *chunkpos        = &bank->chunkpos[first];
+	vec4 one = vec4_set1(1.0f);
+
+	// the extra lanes never attenuate or release
+	float attenuations[BANK_LANES][BANK_BLOCK];
+	float releaserates[BANK_LANES][BANK_BLOCK];
+	float premixgains[BANK_BLOCK][BANK_LANES];
+	for (int i = lanes; i < vecs * 4; i++){
+		for (int n = 0; n < BANK_BLOCK; n++){
+			attenuations[i][n] = 1.0f;
+			releaserates[i][n] = 0.0f;
+		}
+	}
+
+	for (int pos = 0; pos < size; pos += BANK_BLOCK){
+		int len = size - pos;
+		if (len > BANK_BLOCK)
+			len = BANK_BLOCK;
+
+		sf_sample_st **in = &input[first];
+		sf_sample_st **out = &output[first];
+
+		// first pass
+		for (int i = 0; i < lanes; i++)
+			detectchunk(state[i], len, &in[i][pos], attenuations[i], releaserates[i], fast);
+
+		// second pass
+		for (int n = 0; n < len; ){
+			// start a new chunk in the lanes that are at the start of one, and stop the stretch at
+			// the first lane to reach the end of its chunk
+			int stretch = len - n;
+			for (int i = 0; i < lanes; i++){
+				if (chunkpos[i] == 0){
+					startchunk(state[i], state[i]->spu, &detectoravg[i], &compgain[i],
+						&maxcompdiffdb[i], bank->premixgains[first + i], fast);
+				}
+				if (stretch > state[i]->spu - chunkpos[i])
+					stretch = state[i]->spu - chunkpos[i];
+			}
+			const float *premix[BANK_LANES];
+			for (int i = 0; i < vecs * 4; i++)
+				premix[i] = i < lanes ? &bank->premixgains[first + i][chunkpos[i]] : premix[0];
+
+			vec4 avg[BANK_VECS], meter[BANK_VECS], release[BANK_VECS];
+			for (int v = 0; v < vecs; v++){
+				avg[v]     = vec4_load(&detectoravg[v * 4]);
+				meter[v]   = vec4_load(&metergain[v * 4]);
+				release[v] = vec4_load(&meterrelease[v * 4]);
+			}
+
+			// the vectors don't depend on each other, so their steps overlap
+			for (int chi = 0; chi < stretch; chi++, n++){
+				for (int v = 0; v < vecs; v++){
+					const int l = v * 4;
+					vec4 attenuation = vec4_set(attenuations[l][n], attenuations[l + 1][n],
+						attenuations[l + 2][n], attenuations[l + 3][n]);
+					vec4 rate = vec4_set(releaserates[l][n], releaserates[l + 1][n],
+						releaserates[l + 2][n], releaserates[l + 3][n]);
+
+					// the lanes that are releasing use their release rate, the rest jump straight
+					// there
+					rate = vec4_select(vec4_gt(attenuation, avg[v]), rate, one);
+					avg[v] = vec4_add(avg[v], vec4_mul(vec4_sub(attenuation, avg[v]), rate));
+					avg[v] = vec4_select(vec4_gt(avg[v], one), one, avg[v]);
+					// same as fixf (NaN isn't less than anything)
+					avg[v] = vec4_select(vec4_lt(vec4_abs(avg[v]), vec4_set1(INFINITY)), avg[v],
+						one);
+
+					vec4 premixgain = vec4_set(premix[l][chi], premix[l + 1][chi],
+						premix[l + 2][chi], premix[l + 3][chi]);
+					vec4_store(&premixgains[n][l], premixgain);
+
+					// calculate metering (not used in core algo, but used to output a meter if
+					// desired)
+					vec4 premixgaindb;
+					if (fast)
+						premixgaindb = vec4_mul(sample_log2x4(premixgain), vec4_set1(6.02059991f));
+					else{
+						float db[4];
+						for (int i = 0; i < 4; i++)
+							db[i] = l + i < lanes ? lin2db(vec4_get(premixgain, i), false) : 0.0f;
+						premixgaindb = vec4_load(db);
+					}
+					meter[v] = vec4_select(vec4_lt(premixgaindb, meter[v]), premixgaindb,
+						vec4_add(meter[v], vec4_mul(vec4_sub(premixgaindb, meter[v]), release[v])));
+				}
+			}
+
+			for (int v = 0; v < vecs; v++){
+				vec4_store(&detectoravg[v * 4], avg[v]);
+				vec4_store(&metergain[v * 4], meter[v]);
+			}
+			for (int i = 0; i < lanes; i++){
+				chunkpos[i] += stretch;
+				if (chunkpos[i] >= state[i]->spu)
+					chunkpos[i] = 0;
+			}
+		}
+
+		// third pass
+		for (int i = 0; i < lanes; i++){
+			sf_compressor_state_st *st = state[i];
+			float linearpregain = st->linearpregain;
+			float dry = st->dry;
+			float wetmastergain = st->wet * st->mastergain;
+			int delaymask = st->delaymask;
+			int delaywritepos = bank->delaywritepos[first + i];
+			int delayreadpos = bank->delayreadpos[first + i];
+			sf_sample_st *delaybuf = st->delaybuf;
+			for (int n = 0; n < len; n++,
+				delayreadpos = (delayreadpos + 1) & delaymask,
+				delaywritepos = (delaywritepos + 1) & delaymask){
+				delaybuf[delaywritepos] = (sf_sample_st){
+					.L = in[i][pos + n].L * linearpregain,
+					.R = in[i][pos + n].R * linearpregain
+				};
+				float gain = dry + wetmastergain * premixgains[n][i];
+				out[i][pos + n] = (sf_sample_st){
+					.L = delaybuf[delayreadpos].L * gain,
+					.R = delaybuf[delayreadpos].R * gain
+				};
+			}
+			bank->delaywritepos[first + i] = delaywritepos;
+			bank->delayreadpos[first + i] = delayreadpos;
+		}
+	}
+
+	for (int i = 0; i < lanes; i++){
+		bank->metergain[first + i]   = metergain[i];
+		bank->detectoravg[first + i] = detectoravg[i];
+	}
+}
+
+COMPRESSOR_INLINE void bank_run(sf_compressor_bank_st *bank, int size, sf_sample_st **input,
+	sf_sample_st **output, bool fast){
+	uint64_t ftz = ftz_begin();
+	int first = 0;
+	for (; first + BANK_LANES <= bank->size; first += BANK_LANES)
+		bank_group(bank, first, BANK_LANES, BANK_VECS, size, input, output, fast);
+	// the streams left over only need as many vectors as it takes to hold them
+	int left = bank->size - first;
+	if (left > 4)
+		bank_group(bank, first, left, 2, size, input, output, fast);
+	else if (left > 0)
+		bank_group(bank, first, left, 1, size, input, output, fast);
+	ftz_end(ftz);
+}
+
+void sf_compressor_bank_process(sf_compressor_bank_st *bank, int size, sf_sample_st **input,
+	sf_sample_st **output){
+	bank_run(bank, size, input, output, false);
+}
+
+void sf_compressor_bank_process_fast(sf_compressor_bank_st *bank, int size,
+	sf_sample_st **input, sf_sample_st **output){
+	bank_run(bank, size, input, output, true);
 }
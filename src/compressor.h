@@ -9,6 +9,7 @@
 #define SNDFILTER_COMPRESSOR__H
 
 #include "snd.h"
+#include "biquad.h"
 
 // dynamic range compression is a complex topic with many different algorithms
 //
@@ -18,28 +19,49 @@
 // for example, say you're processing a stream in 128 samples per chunk:
 //
 //   sf_compressor_state_st simplecomp;
-//   sf_simplecomp(&simplecomp, 48000, 5, -24, 30, 12, 0.003f, 0.250f);
+//   if (!sf_simplecomp(&simplecomp, 48000, 5, -24, 30, 12, 0.003f, 0.250f))
+//     out of memory
 //
 //   for each 128 length sample:
 //     sf_compressor_process(&simplecomp, 128, input, output);
 //
+//   sf_compressor_free(&simplecomp);
+//
 // notice that sf_compressor_process will change a lot of the member variables inside of the state
 // structure, since these values must be carried over across chunk boundaries
 //
 // also notice that the choice to divide the sound into chunks of 128 samples is completely
-// arbitrary from the compressor's perspective, however, the size should be divisible by the SPU
-// value below (defaults to 32):
-
-// maximum number of samples in the delay buffer
-#define SF_COMPRESSOR_MAXDELAY   1024
+// arbitrary from the compressor's perspective -- any size works, and every input sample produces an
+// output sample; internally, the compressor updates its envelope every SPU samples (see below), and
+// a chunk that ends partway through one of those updates is picked up again by the next call, so
+// the output is the same no matter how the sound is divided up
 
 // samples per update; the compressor works by dividing the input chunks into even smaller sizes,
 // and performs heavier calculations after each mini-chunk to adjust the final envelope
+//
+// sf_advancecomp picks the size for each state, which can be any multiple of 4 up to
+// SF_COMPRESSOR_MAXSPU; smaller sizes react sooner, larger sizes do less work per sample, and
+// sf_defaultcomp/sf_simplecomp use SF_COMPRESSOR_SPU
+//
+// 8, 16, 32, 64 and 128 each get their own copy of the processing loop with the size built in, and
+// other sizes share a general version
 #define SF_COMPRESSOR_SPU        32
+#define SF_COMPRESSOR_MAXSPU     128
 
 // not sure what this does exactly, but it is part of the release curve
 #define SF_COMPRESSOR_SPACINGDB  5.0f
 
+// the compression curve is stored as a table of the attenuation at input levels between
+// 2^CURVEMIN and 2^CURVEMAX (-84dB to +60dB), with 2^CURVEBITS entries per octave, and the inner
+// loop interpolates between the entries instead of calculating the curve for every sample
+// (within 0.003dB of the exact curve, except for up to 0.012dB right at the top of a very wide
+// knee, where the curve bends sharply; louder inputs fall back to the exact curve)
+#define SF_COMPRESSOR_CURVEBITS  5
+#define SF_COMPRESSOR_CURVEMIN   -14
+#define SF_COMPRESSOR_CURVEMAX   10
+#define SF_COMPRESSOR_CURVESIZE  \
+	(((SF_COMPRESSOR_CURVEMAX - SF_COMPRESSOR_CURVEMIN) << SF_COMPRESSOR_CURVEBITS) + 1)
+
 typedef struct {
 	// user can read the metergain state variable after processing a chunk to see how much dB the
 	// compressor would have liked to compress the sample; the meter values aren't used to shape the
@@ -67,19 +89,28 @@ typedef struct {
 	float c;
 	float d;
 	float detectoravg;
-	float compgain;
+	float compgain;          // envelope at the end of the current SPU chunk
 	float maxcompdiffdb;
-	int delaybufsize;
+	int spu;                 // samples per update
+	int chunkpos;            // samples processed so far in the current SPU chunk
+	float premixgains[SF_COMPRESSOR_MAXSPU]; // gain of each sample in the current SPU chunk
+	int delaybufsize; // the sound is delayed by delaybufsize - 1 samples
+	int delaymask;    // size of the buffer (a power of 2), minus 1
 	int delaywritepos;
 	int delayreadpos;
-	sf_sample_st delaybuf[SF_COMPRESSOR_MAXDELAY]; // predelay buffer
+	sf_sample_st *delaybuf; // predelay buffer, allocated with sf_malloc
+	float *curve;           // attenuation table of the compression curve, allocated with delaybuf
 } sf_compressor_state_st;
 
+// the functions that populate a compressor state allocate its predelay buffer (along with the curve
+// table), and return false if that fails; once a state is populated, it must be released with
+// sf_compressor_free before it's populated again or thrown away
+
 // populate a compressor state with all default values
-void sf_defaultcomp(sf_compressor_state_st *state, int rate);
+bool sf_defaultcomp(sf_compressor_state_st *state, int rate);
 
 // populate a compressor state with simple parameters
-void sf_simplecomp(sf_compressor_state_st *state,
+bool sf_simplecomp(sf_compressor_state_st *state,
 	int rate,        // input sample rate (samples per second)
 	float pregain,   // dB, amount to boost the signal before applying compression [0 to 100]
 	float threshold, // dB, level where compression kicks in [-100 to 0]
@@ -90,7 +121,8 @@ void sf_simplecomp(sf_compressor_state_st *state,
 );
 
 // populate a compressor state with advanced parameters
-void sf_advancecomp(sf_compressor_state_st *state,
+// (also returns false if `spu` isn't a multiple of 4 between 4 and SF_COMPRESSOR_MAXSPU)
+bool sf_advancecomp(sf_compressor_state_st *state,
 	// these parameters are the same as the simple version above:
 	int rate, float pregain, float threshold, float knee, float ratio, float attack, float release,
 	// these are the advanced parameters:
@@ -100,12 +132,121 @@ void sf_advancecomp(sf_compressor_state_st *state,
 	float releasezone3, //  the adaptive release curve, which is discussed in further detail in the
 	float releasezone4, //  demo: adaptive-release-curve.html
 	float postgain,     // dB, amount of gain to apply after compression [0 to 100]
-	float wet           // amount to apply the effect [0 completely dry to 1 completely wet]
+	float wet,          // amount to apply the effect [0 completely dry to 1 completely wet]
+	int spu             // samples per envelope update [4 to SF_COMPRESSOR_MAXSPU, usually
+	                    //  SF_COMPRESSOR_SPU]
 );
 
 // this function will process the input sound based on the state passed
-// the input and output buffers should be the same size
+// the input and output buffers should be the same size, and `size` can be any number of samples
 void sf_compressor_process(sf_compressor_state_st *state, int size, sf_sample_st *input,
 	sf_sample_st *output);
 
+// same as sf_compressor_process, but uses fast approximations of the log/exp/pow/sin/asin math
+// instead of calling the math library, which makes it about 1.5-2x faster (see bench/compressor.c)
+// the gain applied to the sound usually stays within 0.0005dB of sf_compressor_process; when an
+// attack/release decision comes out the other way, the two can drift apart briefly, by up to about
+// 0.015dB on input driven well past the threshold
+void sf_compressor_process_fast(sf_compressor_state_st *state, int size, sf_sample_st *input,
+	sf_sample_st *output);
+
+// same as sf_compressor_process, except the compressor listens to `sidechain` to decide how much to
+// compress, while the gain is applied to `input` -- for example, music compressed by a voice in the
+// sidechain ducks under the voice, and a voice compressed by itself through a bandpass around the
+// "s" sounds gets de-essed
+//
+// if `keyfilter` isn't NULL, the sidechain is run through it before the compressor hears it (just
+// like sf_biquad_process, which updates the filter's state), a piece at a time as the compressor
+// needs it, so there's no need to filter the sidechain into a separate buffer first; the sidechain
+// itself is left alone
+//
+// the sidechain has the same pregain applied as the input, and should be the same size; the output
+// can be the same buffer as the input
+void sf_compressor_process_sidechain(sf_compressor_state_st *state, int size, sf_sample_st *input,
+	sf_sample_st *sidechain, sf_sample_st *output, sf_biquad_state_st *keyfilter);
+
+// same as sf_compressor_process_sidechain, with the math of sf_compressor_process_fast
+void sf_compressor_process_sidechain_fast(sf_compressor_state_st *state, int size,
+	sf_sample_st *input, sf_sample_st *sidechain, sf_sample_st *output,
+	sf_biquad_state_st *keyfilter);
+
+// release the predelay buffer (and curve table) of a compressor state
+void sf_compressor_free(sf_compressor_state_st *state);
+
+// banks of compressors
+//
+// when a lot of unrelated sounds each need their own compressor (one per participant of a voice
+// chat, for example), an sf_compressor_bank_st runs up to SF_COMPRESSOR_BANK_MAX of them together,
+// one stream per lane of a SIMD vector -- the envelope of a single compressor has to be worked out
+// one sample after the other, but the envelopes of different streams don't depend on each other
+//
+// each stream is a compressor state populated as usual, so every stream has its own parameters,
+// SPU, predelay and input/output buffers:
+//
+//   sf_compressor_state_st comp[voices];
+//   sf_compressor_bank_st bank;
+//   sf_compressor_bank_init(&bank, voices);
+//   for each voice i:
+//     sf_simplecomp(&comp[i], 48000, 0, threshold[i], 30, ratio[i], 0.003f, 0.250f);
+//     sf_compressor_bank_set(&bank, i, &comp[i]);
+//
+//   for each 128 length sample:
+//     sf_compressor_bank_process(&bank, 128, inputs, outputs);
+//
+// where inputs[i] and outputs[i] point to the buffers for voice i
+//
+// the bank keeps the parts of each stream that change as it's processed (detector, envelope,
+// meter and predelay positions) in its own arrays, and uses the state for everything else,
+// including the curve table and the predelay buffer -- so a state must stay around, and not be
+// freed, while its stream is in the bank; sf_compressor_bank_get copies a stream's progress back
+// into its state, so it can carry on with sf_compressor_process, or be read (for example, its
+// metergain)
+//
+// a stream produces exactly the same output it would with sf_compressor_process (or _fast)
+//
+// the detector and the envelope of a stream depend on the sample before, so they run with one
+// stream per lane, up to 8 streams at a time (in two vectors); the rest already runs several
+// samples of one stream at a time (the same way sf_compressor_process does), so the bank only
+// speeds up that part -- with sf_compressor_bank_process_fast, a bank of 8 or more streams takes
+// about 20% less time per stream than running them one after another, and the normal version,
+// which spends most of its time outside the envelope, gains next to nothing (a bank of a single
+// stream is slower than sf_compressor_process, see bench/compressorbank.c)
+
+// maximum number of streams in a bank
+#define SF_COMPRESSOR_BANK_MAX  16
+
+typedef struct {
+	int size; // number of streams
+	sf_compressor_state_st *state[SF_COMPRESSOR_BANK_MAX]; // the state each stream was set from
+	float meterrelease[SF_COMPRESSOR_BANK_MAX]; // copied out of each state
+	// progress of each stream
+	float metergain[SF_COMPRESSOR_BANK_MAX];
+	float detectoravg[SF_COMPRESSOR_BANK_MAX];
+	float compgain[SF_COMPRESSOR_BANK_MAX];
+	float maxcompdiffdb[SF_COMPRESSOR_BANK_MAX];
+	int chunkpos[SF_COMPRESSOR_BANK_MAX];
+	int delaywritepos[SF_COMPRESSOR_BANK_MAX];
+	int delayreadpos[SF_COMPRESSOR_BANK_MAX];
+	float premixgains[SF_COMPRESSOR_BANK_MAX][SF_COMPRESSOR_MAXSPU];
+} sf_compressor_bank_st;
+
+// initialize a bank with `size` streams, which all need to be set before processing
+void sf_compressor_bank_init(sf_compressor_bank_st *bank, int size);
+
+// put a compressor state into one stream of the bank, picking up where the state left off
+void sf_compressor_bank_set(sf_compressor_bank_st *bank, int stream,
+	sf_compressor_state_st *state);
+
+// copy the progress of one stream back out into the state it was set from
+void sf_compressor_bank_get(sf_compressor_bank_st *bank, int stream);
+
+// process `size` samples of every stream in the bank
+// input[i] and output[i] are the buffers for stream i, and can be the same buffer
+void sf_compressor_bank_process(sf_compressor_bank_st *bank, int size, sf_sample_st **input,
+	sf_sample_st **output);
+
+// same as sf_compressor_bank_process, with the math of sf_compressor_process_fast
+void sf_compressor_bank_process_fast(sf_compressor_bank_st *bank, int size,
+	sf_sample_st **input, sf_sample_st **output);
+
 #endif // SNDFILTER_COMPRESSOR__H
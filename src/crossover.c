@@ -0,0 +1,58 @@
+// (c) Copyright 2016, Sean Connelly (@voidqk), http://syntheti.cc
+// MIT License
+// Project Home: https://github.com/voidqk/sndfilter
+
+#include "crossover.h"
+#include <string.h>
+
+// the bands are split off one at a time, from the bottom up: at each split, the lowpass becomes the
+// next band, and the highpass carries on to the remaining splits
+//
+// a Linkwitz-Riley lowpass and highpass add up to an allpass with the same phase as a Butterworth
+// of half the order, so the band below a split needs that allpass for every split above it, to
+// match the phase of the bands above -- for 3 bands:
+//
+//   band 0 = LP0 * AP1
+//   band 1 = HP0 * LP1
+//   band 2 = HP0 * HP1
+//
+// which add up to LP0 * AP1 + HP0 * (LP1 + HP1) = (LP0 + HP0) * AP1 = AP0 * AP1
+
+bool sf_crossover_init(sf_crossover_st *xo, int rate, int order, int bands, const float *freqs){
+	if (bands < 1 || bands > SF_CROSSOVER_MAX)
+		return false;
+	xo->size = bands;
+	for (int i = 0; i < bands - 1; i++){
+		sf_biquad_chain_init(&xo->lowpass[i]);
+		sf_biquad_chain_init(&xo->highpass[i]);
+		sf_biquad_chain_init(&xo->allpass[i]);
+		if (!sf_linkwitzriley(&xo->lowpass[i], SF_BIQUAD_LOWPASS, order, rate, freqs[i]) ||
+			!sf_linkwitzriley(&xo->highpass[i], SF_BIQUAD_HIGHPASS, order, rate, freqs[i]))
+			return false;
+		for (int j = i + 1; j < bands - 1; j++){
+			if (!sf_butterworth(&xo->allpass[i], SF_BIQUAD_ALLPASS, order / 2, rate, freqs[j]))
+				return false;
+		}
+	}
+	return true;
+}
+
+void sf_crossover_process(sf_crossover_st *xo, int size, sf_sample_st *input,
+	sf_sample_st **output){
+	int last = xo->size - 1;
+	// the highpassed part of the sound that's left to split (which also keeps a copy of the input,
+	// in case the input is the same buffer as an output)
+	sf_sample_st rest[SF_BIQUAD_CHAIN_BLOCK];
+	for (int pos = 0; pos < size; pos += SF_BIQUAD_CHAIN_BLOCK){
+		int len = size - pos;
+		if (len > SF_BIQUAD_CHAIN_BLOCK)
+			len = SF_BIQUAD_CHAIN_BLOCK;
+		memcpy(rest, &input[pos], sizeof(sf_sample_st) * len);
+		for (int i = 0; i < last; i++){
+			sf_biquad_chain_process(&xo->lowpass[i], len, rest, &output[i][pos]);
+			sf_biquad_chain_process(&xo->highpass[i], len, rest, rest);
+			sf_biquad_chain_process(&xo->allpass[i], len, &output[i][pos], &output[i][pos]);
+		}
+		memcpy(&output[last][pos], rest, sizeof(sf_sample_st) * len);
+	}
+}
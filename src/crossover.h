@@ -0,0 +1,55 @@
+// (c) Copyright 2016, Sean Connelly (@voidqk), http://syntheti.cc
+// MIT License
+// Project Home: https://github.com/voidqk/sndfilter
+
+// multiband crossover based on Linkwitz-Riley filters
+
+#ifndef SNDFILTER_CROSSOVER__H
+#define SNDFILTER_CROSSOVER__H
+
+#include "snd.h"
+#include "biquad.h"
+
+// a crossover splits a sound into frequency bands (for example, lows, mids, and highs), which can
+// be processed separately (like a multiband compressor), and then added back together
+//
+// the bands are split with Linkwitz-Riley filters, with extra allpass filters on the lower bands to
+// line up their phase with the higher bands, so adding all of the bands back together gives the
+// original sound, only with its phase shifted (the magnitude is perfectly flat)
+//
+// for example, to split a stream into 3 bands with 128 samples per chunk, you would do:
+//
+//   sf_crossover_st xo;
+//   float freqs[2] = { 200, 2000 };
+//   sf_crossover_init(&xo, 44100, 4, 3, freqs);
+//
+//   for each 128 length sample:
+//     sf_crossover_process(&xo, 128, input, bands);
+//
+// where bands[0] gets everything below 200Hz, bands[1] gets 200Hz to 2000Hz, and bands[2] gets
+// everything above 2000Hz
+//
+// all of the filters run over one small block of samples at a time, so the sound is only streamed
+// through memory once, no matter how many bands there are
+
+// maximum number of bands
+#define SF_CROSSOVER_MAX  8
+
+typedef struct {
+	int size; // number of bands
+	sf_biquad_chain_st lowpass[SF_CROSSOVER_MAX - 1];  // the lowpass at each split
+	sf_biquad_chain_st highpass[SF_CROSSOVER_MAX - 1]; // the highpass at each split
+	sf_biquad_chain_st allpass[SF_CROSSOVER_MAX - 1];  // phase correction for each band
+} sf_crossover_st;
+
+// initialize a crossover with `bands` bands, split at the `bands - 1` frequencies in `freqs` (in
+// Hz, from low to high), using Linkwitz-Riley filters of the given order (4 for LR4, etc)
+// returns false if the settings aren't supported
+bool sf_crossover_init(sf_crossover_st *xo, int rate, int order, int bands, const float *freqs);
+
+// split `size` samples of the input into the bands, where output[i] is the buffer for band i
+// the input can be the same buffer as one of the outputs
+void sf_crossover_process(sf_crossover_st *xo, int size, sf_sample_st *input,
+	sf_sample_st **output);
+
+#endif // SNDFILTER_CROSSOVER__H
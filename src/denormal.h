@@ -0,0 +1,76 @@
+// (c) Copyright 2016, Sean Connelly (@voidqk), http://syntheti.cc
+// MIT License
+// Project Home: https://github.com/voidqk/sndfilter
+
+// denormal protection for the feedback loops inside the library
+//
+// this header is internal -- it isn't included by any of the public headers
+
+#ifndef SNDFILTER_DENORMAL__H
+#define SNDFILTER_DENORMAL__H
+
+#include <stdint.h>
+
+// when a filter's input goes silent, the values circulating in its feedback loops (the biquad
+// history, the reverb's delay lines and all-passes, etc) decay towards zero, and eventually become
+// denormal floats -- tiny numbers that many CPUs handle in microcode, which is dramatically slower
+// than normal floating point math
+//
+// so the processing functions switch the CPU to flush denormals to zero for the duration of the
+// call, and restore whatever mode the caller had afterwards; denormals are far below anything that
+// can be heard (around -750 dB), so flushing them doesn't change the sound
+//
+// on CPUs where there isn't a known way to do this, or if SF_NO_FTZ is defined, these functions
+// don't do anything
+
+#if defined(SF_NO_FTZ)
+#	define SF_FTZ 0
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#	define SF_FTZ 1
+#	include <xmmintrin.h>
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+#	define SF_FTZ 2
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__arm__) && defined(__ARM_FP)
+#	define SF_FTZ 3
+#else
+#	define SF_FTZ 0
+#endif
+
+// start flushing denormals to zero, and return the previous mode so it can be restored
+static inline uint64_t ftz_begin(){
+#if SF_FTZ == 1
+	// MXCSR bit 15 is flush-to-zero, bit 6 is denormals-are-zero
+	unsigned int csr = _mm_getcsr();
+	_mm_setcsr(csr | 0x8040);
+	return csr;
+#elif SF_FTZ == 2
+	// FPCR bit 24 is flush-to-zero
+	uint64_t fpcr;
+	__asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+	__asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr | (1ull << 24)));
+	return fpcr;
+#elif SF_FTZ == 3
+	// FPSCR bit 24 is flush-to-zero
+	uint32_t fpscr;
+	__asm__ __volatile__("vmrs %0, fpscr" : "=r"(fpscr));
+	__asm__ __volatile__("vmsr fpscr, %0" : : "r"(fpscr | (1u << 24)));
+	return fpscr;
+#else
+	return 0;
+#endif
+}
+
+// restore the mode returned by ftz_begin
+static inline void ftz_end(uint64_t mode){
+#if SF_FTZ == 1
+	_mm_setcsr((unsigned int)mode);
+#elif SF_FTZ == 2
+	__asm__ __volatile__("msr fpcr, %0" : : "r"(mode));
+#elif SF_FTZ == 3
+	__asm__ __volatile__("vmsr fpscr, %0" : : "r"((uint32_t)mode));
+#else
+	(void)mode;
+#endif
+}
+
+#endif // SNDFILTER_DENORMAL__H
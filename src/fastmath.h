@@ -0,0 +1,165 @@
+// (c) Copyright 2016, Sean Connelly (@voidqk), http://syntheti.cc
+// MIT License
+// Project Home: https://github.com/voidqk/sndfilter
+
+// fast approximations of the math.h functions, used by the fast paths inside the library
+//
+// this header is internal -- it isn't included by any of the public headers
+
+#ifndef SNDFILTER_FASTMATH__H
+#define SNDFILTER_FASTMATH__H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+// the error of each approximation is listed next to it; they were measured against the math.h
+// version over the whole range that the library uses them for
+
+static inline float fast_bits2float(uint32_t b){
+	float f;
+	memcpy(&f, &b, sizeof(f));
+	return f;
+}
+
+static inline uint32_t fast_float2bits(float f){
+	uint32_t b;
+	memcpy(&b, &f, sizeof(b));
+	return b;
+}
+
+// sin(x) and cos(x) at the same time, for x between -4*pi and 4*pi
+// max absolute error: 1e-6
+static inline void fast_sincosf(float x, float *s, float *c){
+	// split x into a quarter turn q, and a remainder r between -pi/4 and pi/4
+	// (adding and subtracting 1.5 * 2^23 rounds to the nearest integer without a branch)
+	float qf = (x * 0.63661977236f + 12582912.0f) - 12582912.0f; // round(x / (pi / 2))
+	int q = (int)qf;
+	float r = (x - qf * 1.5707963705f) + qf * 4.37113883e-8f; // pi/2 split in two for accuracy
+	// taylor series around 0, which is enough for float precision over [-pi/4, pi/4], with the
+	// terms grouped in pairs so that they don't all wait on each other
+	float r2 = r * r;
+	float r4 = r2 * r2;
+	float sr = r * ((1.0f - 1.6666667e-1f * r2) + (8.3333333e-3f - 1.9841270e-4f * r2) * r4);
+	float cr = (1.0f - 0.5f * r2) + ((4.1666667e-2f - 1.3888889e-3f * r2) +
+		2.4801587e-5f * r4) * r4;
+	// rotate the result based on the quarter turn
+	float ss = (q & 1) ? cr : sr;
+	float cc = (q & 1) ? sr : cr;
+	*s = (q & 2) ? -ss : ss;
+	*c = ((q + 1) & 2) ? -cc : cc;
+}
+
+// sin(x), for x between -4*pi and 4*pi
+// max absolute error: 1e-6
+static inline float fast_sinf(float x){
+	float s, c;
+	fast_sincosf(x, &s, &c);
+	return s;
+}
+
+// cos(x), for x between -4*pi and 4*pi
+// max absolute error: 1e-6
+static inline float fast_cosf(float x){
+	float s, c;
+	fast_sincosf(x, &s, &c);
+	return c;
+}
+
+// 2^x, for x between -126 and 127
+// max relative error: 2e-7
+static inline float fast_exp2f(float x){
+	if (x < -126.0f)
+		x = -126.0f;
+	else if (x > 127.0f)
+		x = 127.0f;
+	int i = (int)(x + (x < 0.0f ? -0.5f : 0.5f)); // round to nearest
+	float f = x - (float)i; // fraction in [-0.5, 0.5]
+	// taylor series for 2^f, which is enough for float precision over [-0.5, 0.5]
+	float p = 1.0f + f * (6.9314718e-1f + f * (2.4022651e-1f + f * (5.5504109e-2f +
+		f * (9.6181291e-3f + f * (1.3333558e-3f + f * 1.5403530e-4f)))));
+	return p * fast_bits2float((uint32_t)(i + 127) << 23);
+}
+
+// 10^x, for x between -37 and 38
+// max relative error: 5e-6 (1e-6 for x between -4 and 4)
+static inline float fast_pow10f(float x){
+	return fast_exp2f(x * 3.32192809489f); // log2(10)
+}
+
+// log2(x), for any x (0 gives -infinity, infinity gives infinity, and negative numbers give NaN,
+// like the math.h version)
+// max absolute error: 1.5e-7 when the result is between -1 and 1, and max relative error 1.2e-7
+// everywhere else (which is under 1e-5 dB when used for 20 * log10(x) between -120dB and +120dB)
+static inline float fast_log2f(float x){
+	if (!(x > 0.0f) || x > 3.4e38f){
+		if (x == 0.0f)
+			return -1.0f / 0.0f;
+		return x > 0.0f ? x : 0.0f / 0.0f;
+	}
+	// split x into 2^e * m, with m between sqrt(1/2) and sqrt(2)
+	uint32_t bits = fast_float2bits(x);
+	int e = (int)((bits >> 23) & 0xFF) - 127;
+	bits = (bits & 0x007FFFFF) | 0x3F800000;
+	if (bits > 0x3FB504F3){ // m > sqrt(2)
+		bits -= 0x00800000;
+		e++;
+	}
+	float m = fast_bits2float(bits);
+	// log2(m) = 2 / ln(2) * atanh(t), where t = (m - 1) / (m + 1) is between -0.172 and 0.172, so
+	// a few terms of the atanh series are enough for float precision
+	float t = (m - 1.0f) / (m + 1.0f);
+	float t2 = t * t;
+	float p = t * (2.88539008f + t2 * (0.961796694f + t2 * (0.577078016f + t2 * 0.412198583f)));
+	return (float)e + p;
+}
+
+// log10(x), with the same range and error as fast_log2f (scaled by log10(2))
+static inline float fast_log10f(float x){
+	return fast_log2f(x) * 0.301029996f;
+}
+
+// asin(x), for x between -1 and 1
+// max relative error: 2e-7
+static inline float fast_asinf(float x){
+	// this is the reduction and polynomial from Cephes asinf: below 0.5, the odd series around 0 is
+	// used directly, and above it, asin(x) = pi/2 - 2 * asin(sqrt((1 - x) / 2)) moves the value
+	// back below 0.5, where the series works
+	float ax = x < 0.0f ? -x : x;
+	bool big = ax > 0.5f;
+	float z = big ? 0.5f * (1.0f - ax) : ax * ax;
+	float w = big ? sqrtf(z) : ax;
+	float p = ((((4.2163199048e-2f * z + 2.4181311049e-2f) * z + 4.5470025998e-2f) * z +
+		7.4953002686e-2f) * z + 1.6666752422e-1f) * z * w + w;
+	float a = big ? 1.57079633f - 2.0f * p : p;
+	return x < 0.0f ? -a : a;
+}
+
+// atan2(y, x), for any x and y (returns 0 when both are 0)
+// max absolute error: 3e-7
+static inline float fast_atan2f(float y, float x){
+	float ax = x < 0.0f ? -x : x;
+	float ay = y < 0.0f ? -y : y;
+	float hi = ax > ay ? ax : ay;
+	float lo = ax > ay ? ay : ax;
+	if (hi == 0.0f)
+		return 0.0f;
+	// atan(lo / hi) is between 0 and pi/4, and above tan(pi/8) it's moved down by pi/4 using
+	// atan(t) = pi/4 + atan((t - 1) / (t + 1)), so the polynomial only needs to cover
+	// [-tan(pi/8), tan(pi/8)] (this is the reduction and polynomial from Cephes atanf)
+	bool big = lo > 0.41421356f * hi;
+	float t = (big ? lo - hi : lo) / (big ? lo + hi : hi);
+	float base = big ? 0.78539816f : 0.0f;
+	float z = t * t;
+	float a = base + t + t * z * (((8.05374449538e-2f * z - 1.38776856032e-1f) * z +
+		1.99777106478e-1f) * z - 3.33329491539e-1f);
+	// put the angle back in the right octant
+	if (ay > ax)
+		a = 1.57079633f - a;
+	if (x < 0.0f)
+		a = 3.14159265f - a;
+	return y < 0.0f ? -a : a;
+}
+
+#endif // SNDFILTER_FASTMATH__H
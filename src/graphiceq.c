@@ -0,0 +1,124 @@
+// (c) Copyright 2016, Sean Connelly (@voidqk), http://syntheti.cc
+// MIT License
+// Project Home: https://github.com/voidqk/sndfilter
+
+#include "graphiceq.h"
+#include "simd.h"
+#include <math.h>
+#include <string.h>
+
+// the bands are designed in groups of 4, so the arrays are padded up to a multiple of 4
+#define GEQ_PADDED  32
+
+// center frequency of each band, 1000 * 2^((band - 17) / 3)
+static const float geq_freqs[GEQ_PADDED] = {
+	   19.686f,    24.803f,    31.250f,    39.373f,    49.606f,    62.500f,    78.745f,    99.213f,
+	  125.000f,   157.490f,   198.425f,   250.000f,   314.980f,   396.850f,   500.000f,   629.961f,
+	  793.701f,  1000.000f,  1259.921f,  1587.401f,  2000.000f,  2519.842f,  3174.802f,  4000.000f,
+	 5039.684f,  6349.604f,  8000.000f, 10079.368f, 12699.208f, 16000.000f, 20158.737f,     0.000f
+};
+
+void sf_graphiceq_init(sf_graphiceq_st *eq, int rate, float Q){
+	eq->rate = rate;
+	eq->Q = Q;
+	for (int i = 0; i < SF_GRAPHICEQ_BANDS; i++){
+		eq->gain[i] = 0.0f;
+		eq->band[i] = 0;
+	}
+	sf_biquad_chain_init(&eq->chain);
+}
+
+// the peaking filter is the same formula as sf_peaking, with the coefficients calculated for four
+// bands at once:
+//
+//   A     = 10^(gain / 40)
+//   alpha = sin(w0) / (2 * Q)
+//   b0 = (1 + alpha * A) / a0,  b1 = a1 = -2 * cos(w0) / a0,  b2 = (1 - alpha * A) / a0
+//   a2 = (1 - alpha / A) / a0,  where a0 = 1 + alpha / A
+//
+// w0 = 2 * pi * freq / rate is between 0 and pi, which is outside the range of vec4_sincos, so the
+// sin and cos are calculated for a quarter of the angle and doubled up twice
+static void geq_design(const float *freqs, const float *gains, float wscale, float Q, float *b0,
+	float *b1, float *b2, float *a2){
+	for (int i = 0; i < GEQ_PADDED; i += 4){
+		vec4 one = vec4_set1(1.0f);
+		vec4 two = vec4_set1(2.0f);
+
+		// quarter angle, between 0 and pi/4
+		vec4 x = vec4_mul(vec4_load(&freqs[i]), vec4_set1(wscale * 0.25f));
+		x = vec4_select(vec4_gt(x, vec4_set1(0.78539816f)), vec4_set1(0.78539816f), x);
+		vec4 sq, cq;
+		vec4_sincos(x, &sq, &cq);
+		vec4 sh = vec4_mul(two, vec4_mul(sq, cq));
+		vec4 ch = vec4_sub(one, vec4_mul(two, vec4_mul(sq, sq)));
+		vec4 sinw = vec4_mul(two, vec4_mul(sh, ch));
+		// the cos uses 1 - 2 * sin^2, which is more precise than cos^2 - sin^2 for the low bands,
+		// where the cos is right next to 1
+		vec4 cosw = vec4_sub(one, vec4_mul(two, vec4_mul(sh, sh)));
+
+		// square root of gain converted from dB to linear, 10^(gain / 40) = 2^(gain * log2(10) / 40)
+		vec4 A = vec4_exp2(vec4_mul(vec4_load(&gains[i]), vec4_set1(0.08304820237f)));
+		vec4 alpha = vec4_mul(sinw, vec4_set1(0.5f / Q));
+		vec4 aA = vec4_mul(alpha, A);
+		vec4 adA = vec4_div(alpha, A);
+		vec4 a0inv = vec4_div(one, vec4_add(one, adA));
+		vec4_store(&b0[i], vec4_mul(a0inv, vec4_add(one, aA)));
+		vec4_store(&b1[i], vec4_mul(a0inv, vec4_mul(vec4_set1(-2.0f), cosw)));
+		vec4_store(&b2[i], vec4_mul(a0inv, vec4_sub(one, aA)));
+		vec4_store(&a2[i], vec4_mul(a0inv, vec4_sub(one, adA)));
+	}
+}
+
+void sf_graphiceq_set(sf_graphiceq_st *eq, const float *gains){
+	float g[GEQ_PADDED] = { 0 };
+	for (int i = 0; i < SF_GRAPHICEQ_BANDS; i++){
+		eq->gain[i] = gains[i];
+		g[i] = gains[i];
+	}
+
+	float b0[GEQ_PADDED], b1[GEQ_PADDED], b2[GEQ_PADDED], a2[GEQ_PADDED];
+	geq_design(geq_freqs, g, (float)M_PI * 2.0f / (float)eq->rate, eq->Q, b0, b1, b2, a2);
+
+	// rebuild the chain out of the bands that are in use, in order of frequency
+	//
+	// a band that was already in use keeps its state; a band that wasn't in use was passing the
+	// sound through untouched, so its state is the sound at that spot in the old chain, which is
+	// the output of the section before it (or the input of the chain, if it's first)
+	sf_biquad_chain_st old = eq->chain;
+	int oldband[SF_GRAPHICEQ_BANDS];
+	memcpy(oldband, eq->band, sizeof(oldband));
+	sf_biquad_chain_init(&eq->chain);
+	int o = 0; // next section of the old chain
+	sf_sample_st zero = { 0, 0 };
+	for (int i = 0; i < SF_GRAPHICEQ_BANDS; i++){
+		// catch up with the old chain
+		while (o < old.size && oldband[o] < i)
+			o++;
+		if (g[i] == 0.0f || geq_freqs[i] * 2.0f >= (float)eq->rate)
+			continue;
+		sf_biquad_state_st *s = sf_biquad_chain_add(&eq->chain);
+		eq->band[eq->chain.size - 1] = i;
+		if (o < old.size && oldband[o] == i)
+			*s = old.sections[o];
+		else if (o > 0){
+			s->xn1 = s->yn1 = old.sections[o - 1].yn1;
+			s->xn2 = s->yn2 = old.sections[o - 1].yn2;
+		}
+		else if (old.size > 0){
+			s->xn1 = s->yn1 = old.sections[0].xn1;
+			s->xn2 = s->yn2 = old.sections[0].xn2;
+		}
+		else
+			s->xn1 = s->xn2 = s->yn1 = s->yn2 = zero;
+		s->b0 = b0[i];
+		s->b1 = b1[i];
+		s->b2 = b2[i];
+		s->a1 = b1[i];
+		s->a2 = a2[i];
+	}
+}
+
+void sf_graphiceq_process(sf_graphiceq_st *eq, int size, sf_sample_st *input,
+	sf_sample_st *output){
+	sf_biquad_chain_process(&eq->chain, size, input, output);
+}
@@ -0,0 +1,69 @@
+// (c) Copyright 2016, Sean Connelly (@voidqk), http://syntheti.cc
+// MIT License
+// Project Home: https://github.com/voidqk/sndfilter
+
+// 31 band graphic equalizer
+
+#ifndef SNDFILTER_GRAPHICEQ__H
+#define SNDFILTER_GRAPHICEQ__H
+
+#include "snd.h"
+#include "biquad.h"
+
+// a graphic equalizer has one peaking filter for each of the 31 third-octave bands between 20Hz and
+// 20kHz, where each band is exactly a third of an octave away from its neighbors, and band 17 is
+// 1kHz: 1000 * 2^((band - 17) / 3) Hz
+//
+// the names of the ISO bands (ISO 266: 20Hz, 25Hz, 31.5Hz, ... 16kHz, 20kHz) are only nominal for
+// these centers, which come out at 19.69Hz, 24.8Hz, 31.25Hz, ... 16kHz, 20.16kHz
+//
+// all of the bands are designed at once, four at a time with vector math, and only the bands that
+// actually change the sound are kept: bands set to 0dB, and bands at or above the nyquist frequency
+// (for example, 20kHz at 32000Hz), are skipped entirely
+//
+// the bands that are left run as one biquad chain, so the sound is only streamed through memory
+// once (see sf_biquad_chain_st)
+//
+// for example, to boost the lows and cut the highs over a stream with 128 samples per chunk:
+//
+//   sf_graphiceq_st eq;
+//   sf_graphiceq_init(&eq, 44100, SF_GRAPHICEQ_Q);
+//   float gains[SF_GRAPHICEQ_BANDS] = { 6, 6, 6, 4, 2 }; // the rest are 0
+//   gains[30] = -6;
+//   sf_graphiceq_set(&eq, gains);
+//
+//   for each 128 length sample:
+//     sf_graphiceq_process(&eq, 128, input, output);
+//
+// note that the band frequencies are the actual frequencies in the sound; sf_peaking places its
+// frequency at twice the value given (see sf_biquad_response)
+
+// number of bands
+#define SF_GRAPHICEQ_BANDS  31
+
+// the Q that gives each band a bandwidth of a third of an octave
+#define SF_GRAPHICEQ_Q      4.318f
+
+typedef struct {
+	int rate;
+	float Q;
+	float gain[SF_GRAPHICEQ_BANDS]; // gain of each band (dB)
+	int band[SF_GRAPHICEQ_BANDS];   // which band each section of the chain belongs to
+	sf_biquad_chain_st chain;       // one section for each band that's in use
+} sf_graphiceq_st;
+
+// initialize a graphic equalizer with every band at 0dB, where `Q` sets the width of the bands
+// (SF_GRAPHICEQ_Q, or larger for narrower bands that overlap less)
+void sf_graphiceq_init(sf_graphiceq_st *eq, int rate, float Q);
+
+// set the gain of every band at once, where gains[i] is the gain of band i (in dB)
+// this can be called between chunks: bands that stay in use keep their state, and bands that are
+// turned on start from the sound flowing through that spot in the chain, so there aren't any clicks
+void sf_graphiceq_set(sf_graphiceq_st *eq, const float *gains);
+
+// this function will process the input sound based on the state passed
+// the input and output buffers should be the same size, and can be the same buffer
+void sf_graphiceq_process(sf_graphiceq_st *eq, int size, sf_sample_st *input,
+	sf_sample_st *output);
+
+#endif // SNDFILTER_GRAPHICEQ__H
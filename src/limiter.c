@@ -0,0 +1,219 @@
+// (c) Copyright 2016, Sean Connelly (@voidqk), http://syntheti.cc
+// MIT License
+// Project Home: https://github.com/voidqk/sndfilter
+
+#include "limiter.h"
+#include "simd.h"
+#include "denormal.h"
+#include "mem.h"
+#include <math.h>
+#include <string.h>
+
+bool sf_limiter_init(sf_limiter_st *lim, int rate, float ceiling, float lookahead, float release,
+	bool truepeak){
+	// the look-ahead is up to one second long, and uses the same kind of buffer as the compressor's
+	// predelay: rounded up to a power of 2, so the positions wrap around with a mask, and the read
+	// position trails the write position by the delay
+	//
+	// the window minimums and the queue use the same size, and come out of one allocation; a new
+	// gain joins the queue before the one that just left the window is dropped, so for a moment the
+	// queue can hold window + 1 gains, which needs room for one more than the look-ahead
+	int window = rate * lookahead;
+	if (window < 1)
+		window = 1;
+	else if (window > rate)
+		window = rate;
+	int delaymask = 1;
+	while (delaymask < window + 1)
+		delaymask <<= 1;
+	delaymask--;
+	int bufsize = delaymask + 1;
+	unsigned char *mem = sf_malloc(bufsize *
+		(sizeof(sf_sample_st) + sizeof(float) * 3 + sizeof(uint32_t)));
+	if (mem == NULL)
+		return false;
+	memset(lim, 0, sizeof(sf_limiter_st));
+	lim->delaybuf  = (sf_sample_st *)mem;
+	lim->delaygain = (float *)(lim->delaybuf + bufsize);
+	lim->boxbuf    = lim->delaygain + bufsize;
+	lim->queuegain = lim->boxbuf + bufsize;
+	lim->queuetime = (uint32_t *)(lim->queuegain + bufsize);
+	memset(lim->delaybuf, 0, sizeof(sf_sample_st) * bufsize);
+	for (int i = 0; i < bufsize; i++){
+		// silence before the start doesn't need any gain reduction
+		lim->delaygain[i] = 1.0f;
+		lim->boxbuf[i] = 1.0f;
+	}
+
+	lim->ceiling       = powf(10.0f, ceiling / 20.0f);
+	lim->releasecoef   = release * rate < 1.0f ? 1.0f : 1.0f - expf(-1.0f / (release * rate));
+	lim->gain          = 1.0f;
+	lim->window        = window;
+	lim->windowinv     = 1.0f / window;
+	lim->windowsum     = window;
+	lim->delaymask     = delaymask;
+	lim->delaywritepos = 0;
+	lim->delayreadpos  = (1 - window) & delaymask;
+	lim->latency       = window - 1;
+
+	// the oversampling filter is a windowed sinc, with one phase for each of the points at 1/4, 2/4
+	// and 3/4 of the way between two samples; each phase is normalized so it passes DC unchanged
+	lim->truepeak = truepeak;
+	if (truepeak){
+		lim->latency += SF_LIMITER_TRUEPEAKDELAY;
+		float halfwidth = SF_LIMITER_TRUEPEAKDELAY;
+		for (int p = 0; p < 3; p++){
+			float f = (p + 1) * 0.25f;
+			float total = 0.0f;
+			for (int j = 0; j < SF_LIMITER_TRUEPEAKTAPS; j++){
+				// tap j is for the sample (j - DELAY + 1) after the one being measured
+				float t = (float)M_PI * (f - (j - SF_LIMITER_TRUEPEAKDELAY + 1));
+				float h = sinf(t) / t;
+				float w = 0.5f + 0.5f * cosf(t / halfwidth);
+				lim->fir[j][p] = h * w;
+				total += h * w;
+			}
+			for (int j = 0; j < SF_LIMITER_TRUEPEAKTAPS; j++)
+				lim->fir[j][p] /= total;
+		}
+	}
+	return true;
+}
+
+// the highest of the 3 points in between the samples `hist[DELAY - 1]` and `hist[DELAY]`, for both
+// channels; the 3 points are worked out together, one per lane
+static inline float intersamplepeak(const float fir[SF_LIMITER_TRUEPEAKTAPS][4],
+	const float *histL, const float *histR){
+	vec4 yL = vec4_set1(0.0f);
+	vec4 yR = vec4_set1(0.0f);
+	for (int j = 0; j < SF_LIMITER_TRUEPEAKTAPS; j++){
+		vec4 h = vec4_set(fir[j][0], fir[j][1], fir[j][2], fir[j][3]);
+		yL = vec4_add(yL, vec4_mul(h, vec4_set1(histL[j])));
+		yR = vec4_add(yR, vec4_mul(h, vec4_set1(histR[j])));
+	}
+	yL = vec4_abs(yL);
+	yR = vec4_abs(yR);
+	float peak = 0.0f;
+	for (int p = 0; p < 3; p++)
+		peak = fmaxf(peak, fmaxf(vec4_get(yL, p), vec4_get(yR, p)));
+	return peak;
+}
+
+void sf_limiter_process(sf_limiter_st *lim, int size, sf_sample_st *input, sf_sample_st *output){
+	uint64_t ftz = ftz_begin();
+
+	// pull out the state into local variables
+	float ceiling          = lim->ceiling;
+	float releasecoef      = lim->releasecoef;
+	float gain             = lim->gain;
+	int window             = lim->window;
+	float windowinv        = lim->windowinv;
+	double windowsum       = lim->windowsum;
+	int delaymask          = lim->delaymask;
+	int delaywritepos      = lim->delaywritepos;
+	int delayreadpos       = lim->delayreadpos;
+	sf_sample_st *delaybuf = lim->delaybuf;
+	float *delaygain       = lim->delaygain;
+	float *boxbuf          = lim->boxbuf;
+	float *queuegain       = lim->queuegain;
+	uint32_t *queuetime    = lim->queuetime;
+	int queuehead          = lim->queuehead;
+	int queuetail          = lim->queuetail;
+	uint32_t time          = lim->time;
+	bool truepeak          = lim->truepeak;
+	int firpos             = lim->firpos;
+	float firprevpeak      = lim->firprevpeak;
+	float *firL            = lim->firL;
+	float *firR            = lim->firR;
+
+	for (int samplepos = 0; samplepos < size; samplepos++,
+		delayreadpos = (delayreadpos + 1) & delaymask,
+		delaywritepos = (delaywritepos + 1) & delaymask){
+		// measure the peak of the sample
+		sf_sample_st in = input[samplepos];
+		float peak;
+		if (truepeak){
+			// the recent samples are written twice, TAPS apart, so the last TAPS of them are always
+			// in order starting at firpos + 1, without having to wrap around
+			firL[firpos] = firL[firpos + SF_LIMITER_TRUEPEAKTAPS] = in.L;
+			firR[firpos] = firR[firpos + SF_LIMITER_TRUEPEAKTAPS] = in.R;
+			float *histL = &firL[firpos + 1];
+			float *histR = &firR[firpos + 1];
+			firpos = (firpos + 1) & (SF_LIMITER_TRUEPEAKTAPS - 1);
+
+			// the filter needs samples on both sides of the points it measures, so it works on
+			// the sample from DELAY samples ago, which is taken as the sample to limit; its peak
+			// includes the points on both sides of it
+			in = (sf_sample_st){
+				.L = histL[SF_LIMITER_TRUEPEAKDELAY - 1],
+				.R = histR[SF_LIMITER_TRUEPEAKDELAY - 1]
+			};
+			float nextpeak = intersamplepeak(lim->fir, histL, histR);
+			peak = fmaxf(fmaxf(fabsf(in.L), fabsf(in.R)), fmaxf(firprevpeak, nextpeak));
+			firprevpeak = nextpeak;
+		}
+		else
+			peak = fmaxf(fabsf(in.L), fabsf(in.R));
+
+		// the gain that puts the sample right at the ceiling
+		float target = peak > ceiling ? ceiling / peak : 1.0f;
+
+		// smallest target over the window: the queue holds the targets that are still in the window
+		// and are smaller than every target after them, so the head is the smallest; each target is
+		// added and removed once, so this is constant time on average
+		while (queuetail != queuehead && queuegain[(queuetail - 1) & delaymask] >= target)
+			queuetail--;
+		queuegain[queuetail & delaymask] = target;
+		queuetime[queuetail & delaymask] = time;
+		queuetail++;
+		if (time - queuetime[queuehead & delaymask] >= (uint32_t)window)
+			queuehead++;
+		time++;
+		float windowmin = queuegain[queuehead & delaymask];
+
+		// average of the window minimums over the window; every one of them is at most the target
+		// of the sample coming out of the delay, since their windows all include it, so the average
+		// is too -- and it ramps down in a straight line, reaching the target right at the peak
+		windowsum += windowmin - boxbuf[(delaywritepos - window) & delaymask];
+		boxbuf[delaywritepos] = windowmin;
+		float smoothgain = windowsum * windowinv;
+
+		// delay the sample, along with its target
+		delaybuf[delaywritepos] = in;
+		delaygain[delaywritepos] = target;
+
+		// follow the smoothed gain down right away, and recover towards it over the release time;
+		// the delayed sample's own target has the final say, so rounding in the running sum can
+		// never push a sample over the ceiling
+		if (smoothgain < gain)
+			gain = smoothgain;
+		else
+			gain += (smoothgain - gain) * releasecoef;
+		if (gain > delaygain[delayreadpos])
+			gain = delaygain[delayreadpos];
+
+		output[samplepos] = (sf_sample_st){
+			.L = delaybuf[delayreadpos].L * gain,
+			.R = delaybuf[delayreadpos].R * gain
+		};
+	}
+
+	// save the state for the next chunk
+	lim->gain          = gain;
+	lim->windowsum     = windowsum;
+	lim->delaywritepos = delaywritepos;
+	lim->delayreadpos  = delayreadpos;
+	lim->queuehead     = queuehead;
+	lim->queuetail     = queuetail;
+	lim->time          = time;
+	lim->firpos        = firpos;
+	lim->firprevpeak   = firprevpeak;
+
+	ftz_end(ftz);
+}
+
+void sf_limiter_free(sf_limiter_st *lim){
+	// the other buffers are part of the same allocation as delaybuf
+	sf_free(lim->delaybuf);
+	lim->delaybuf = NULL;
+}
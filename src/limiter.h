@@ -0,0 +1,100 @@
+// (c) Copyright 2016, Sean Connelly (@voidqk), http://syntheti.cc
+// MIT License
+// Project Home: https://github.com/voidqk/sndfilter
+
+// look-ahead brickwall limiter
+
+#ifndef SNDFILTER_LIMITER__H
+#define SNDFILTER_LIMITER__H
+
+#include "snd.h"
+#include <stdint.h>
+
+// a limiter keeps the sound from ever going over a ceiling, usually placed at the very end of a
+// chain (after a compressor, for example), so the sound can't clip
+//
+// the sound is delayed by the look-ahead time, the same way the compressor's predelay works, so the
+// limiter sees a peak coming before it reaches the output, and has time to turn the gain down
+// smoothly instead of all at once
+//
+// for example, to limit a stream to -1dB with 5ms of look-ahead, 128 samples per chunk:
+//
+//   sf_limiter_st lim;
+//   if (!sf_limiter_init(&lim, 48000, -1, 0.005f, 0.1f, false))
+//     out of memory
+//
+//   for each 128 length sample:
+//     sf_limiter_process(&lim, 128, input, output);
+//
+//   sf_limiter_free(&lim);
+//
+// for each sample, the gain that would put its peak right at the ceiling is fed through a sliding
+// window that keeps the smallest gain of the look-ahead, and then a moving average over the same
+// window, which lowers the gain in a straight line ending at the peak; both keep running totals
+// (the window keeps a queue of the gains that can still be the smallest), so the cost per sample
+// stays the same no matter how long the look-ahead is
+//
+// after a peak, the gain recovers towards 1 over the release time
+//
+// with `truepeak` set, the peaks are measured on the sound oversampled 4 times, which catches the
+// peaks in between the samples that show up after the sound is converted to analog (or resampled);
+// this adds SF_LIMITER_TRUEPEAKDELAY samples to the delay, and keeps the true peak within about
+// half a dB of the ceiling (4x oversampling can still miss a bit of a peak near the Nyquist
+// frequency)
+//
+// both channels get the same gain, so the stereo image doesn't move around
+
+// number of taps in each phase of the oversampling filter (a power of 2), and the delay it adds
+#define SF_LIMITER_TRUEPEAKTAPS   32
+#define SF_LIMITER_TRUEPEAKDELAY  (SF_LIMITER_TRUEPEAKTAPS / 2)
+
+typedef struct {
+	int latency;       // the sound is delayed by this many samples
+	float ceiling;     // linear ceiling
+	float releasecoef; // fraction of the way back to 1 the gain recovers each sample
+	float gain;        // gain applied to the last sample
+	int window;        // look-ahead in samples, including the sample itself
+	float windowinv;
+	double windowsum;  // sum of the window minimums in boxbuf
+	// the buffers are all the same size (a power of 2), and wrap around with delaymask
+	int delaymask;
+	int delaywritepos;
+	int delayreadpos;
+	sf_sample_st *delaybuf; // the sound, delayed by the look-ahead, allocated with sf_malloc
+	float *delaygain;       // the gain that puts each delayed sample at the ceiling
+	float *boxbuf;          // the window minimum for each of the last `window` samples
+	// queue of gains that might still become the smallest in the window, increasing from head to
+	// tail, along with the sample count when each gain was added
+	float *queuegain;
+	uint32_t *queuetime;
+	int queuehead;
+	int queuetail;
+	uint32_t time;
+	// true peak oversampling
+	bool truepeak;
+	int firpos;
+	float firprevpeak; // peak between the last two samples
+	float firL[SF_LIMITER_TRUEPEAKTAPS * 2]; // recent samples, stored twice (see limiter.c)
+	float firR[SF_LIMITER_TRUEPEAKTAPS * 2];
+	// filter for each of the 3 points in between samples, stored tap by tap (the 4th is unused)
+	float fir[SF_LIMITER_TRUEPEAKTAPS][4];
+} sf_limiter_st;
+
+// initialize a limiter, and allocate its buffers
+// returns false if that fails
+bool sf_limiter_init(sf_limiter_st *lim,
+	int rate,         // input sample rate (samples per second)
+	float ceiling,    // dB, the sound never goes above this level [-100 to 0]
+	float lookahead,  // seconds, how far ahead the limiter looks for peaks [0 to 1]
+	float release,    // seconds, how long the gain takes to recover after a peak [0 to 1]
+	bool truepeak     // measure the peaks in between samples, with 4x oversampling
+);
+
+// process `size` samples of the input
+// the input and output can be the same buffer
+void sf_limiter_process(sf_limiter_st *lim, int size, sf_sample_st *input, sf_sample_st *output);
+
+// release the buffers of a limiter
+void sf_limiter_free(sf_limiter_st *lim);
+
+#endif // SNDFILTER_LIMITER__H
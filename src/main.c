@@ -136,6 +136,7 @@ static inline int biquad(sf_snd input_snd, sf_biquad_state_st *state, const char
 static inline int compressor(sf_snd input_snd, sf_compressor_state_st *state, const char *output){
 	sf_snd output_snd = sf_snd_new(input_snd->size, input_snd->rate, true);
 	if (output_snd == NULL){
+		sf_compressor_free(state);
 		sf_snd_free(input_snd);
 		fprintf(stderr, "Error: Failed to apply filter\n");
 		return 1;
@@ -143,11 +144,7 @@ static inline int compressor(sf_snd input_snd, sf_compressor_state_st *state, co
 
 	// process the compressor in one sweep
 	sf_compressor_process(state, input_snd->size, input_snd->samples, output_snd->samples);
-
-	// note that the compressor does not output one sample per input sample, because the compressor
-	// works in subchunks of 32 samples (this is defined via SF_COMPRESSOR_SPU in compressor.c)
-	//
-	// that means the output size will be floor(input_size / 32) * 32
+	sf_compressor_free(state);
 
 	bool res = sf_wavsave(output_snd, output);
 	sf_snd_free(input_snd);
@@ -294,8 +291,12 @@ int main(int argc, char **argv){
 		if (!getargs(argc, argv, 6, params))
 			return badargs(filter);
 		sf_compressor_state_st cm_state;
-		sf_simplecomp(&cm_state, input_snd->rate, params[0], params[1], params[2], params[3],
-			params[4], params[5]);
+		if (!sf_simplecomp(&cm_state, input_snd->rate, params[0], params[1], params[2],
+			params[3], params[4], params[5])){
+			sf_snd_free(input_snd);
+			fprintf(stderr, "Error: Failed to apply filter\n");
+			return 1;
+		}
 		return compressor(input_snd, &cm_state, output);
 	}
 	else if (strcmp(filter, "reverb") == 0){
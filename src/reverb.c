@@ -3,6 +3,7 @@
 // Project Home: https://github.com/voidqk/sndfilter
 
 #include "reverb.h"
+#include "denormal.h"
 #include <math.h>
 #include <stdint.h>
 #include <stdbool.h>
@@ -783,6 +784,8 @@ void sf_advancereverb(sf_reverb_state_st *rv, int rate,
 }
 
 void sf_reverb_process(sf_reverb_state_st *rv, int size, sf_sample_st *input, sf_sample_st *output){
+	uint64_t ftz = ftz_begin();
+
 	// extra hardcoded constants
 	const float modnoise1 = 0.09f;
 	const float modnoise2 = 0.06f;
@@ -927,4 +930,5 @@ void sf_reverb_process(sf_reverb_state_st *rv, int size, sf_sample_st *input, sf
 		outR += er.R * rv->erefwet + input[i].R * rv->dry;
 		output[i] = (sf_sample_st){ outL, outR };
 	}
+	ftz_end(ftz);
 }
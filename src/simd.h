@@ -0,0 +1,352 @@
+// (c) Copyright 2016, Sean Connelly (@voidqk), http://syntheti.cc
+// MIT License
+// Project Home: https://github.com/voidqk/sndfilter
+
+// tiny 4-lane float vector used by the SIMD kernels inside the library
+//
+// this header is internal -- it isn't included by any of the public headers
+
+#ifndef SNDFILTER_SIMD__H
+#define SNDFILTER_SIMD__H
+
+#include "snd.h"
+#include "fastmath.h"
+#include <stdbool.h>
+#include <string.h>
+
+// when compiling with clang or gcc, the vector type uses the compiler's vector extensions, which
+// turn into SSE instructions on x86 and NEON instructions on ARM automatically, based on the target
+// the code is compiled for
+//
+// every other compiler (or defining SF_NO_SIMD) gets a plain struct with the same functions, so
+// the kernels built on top of this header still work, just one lane at a time
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(SF_NO_SIMD)
+#	define SF_SIMD 1
+#else
+#	define SF_SIMD 0
+#endif
+
+#if SF_SIMD
+
+typedef float vec4 __attribute__((vector_size(16)));
+
+static inline vec4 vec4_set(float a, float b, float c, float d){
+	return (vec4){ a, b, c, d };
+}
+
+static inline vec4 vec4_set1(float v){
+	return (vec4){ v, v, v, v };
+}
+
+static inline float vec4_get(vec4 v, int i){
+	return v[i];
+}
+
+static inline vec4 vec4_add(vec4 a, vec4 b){
+	return a + b;
+}
+
+static inline vec4 vec4_sub(vec4 a, vec4 b){
+	return a - b;
+}
+
+static inline vec4 vec4_mul(vec4 a, vec4 b){
+	return a * b;
+}
+
+static inline vec4 vec4_div(vec4 a, vec4 b){
+	return a / b;
+}
+
+// comparisons return a mask with all bits set in the lanes where the comparison is true, which
+// can be used by vec4_select
+typedef int vec4mask __attribute__((vector_size(16)));
+
+static inline vec4mask vec4_lt(vec4 a, vec4 b){
+	return a < b;
+}
+
+static inline vec4mask vec4_gt(vec4 a, vec4 b){
+	return a > b;
+}
+
+// pick `a` in the lanes where the mask is set, and `b` everywhere else
+static inline vec4 vec4_select(vec4mask mask, vec4 a, vec4 b){
+	return (vec4)((mask & (vec4mask)a) | (~mask & (vec4mask)b));
+}
+
+static inline vec4 vec4_abs(vec4 v){
+	return (vec4)((vec4mask)v & 0x7FFFFFFF);
+}
+
+// four int lanes, for working with the bits of the floats
+typedef int vec4i __attribute__((vector_size(16)));
+
+static inline vec4i vec4i_set1(int v){
+	return (vec4i){ v, v, v, v };
+}
+
+static inline int vec4i_get(vec4i v, int i){
+	return v[i];
+}
+
+static inline vec4i vec4i_add(vec4i a, vec4i b){
+	return a + b;
+}
+
+static inline vec4i vec4i_sub(vec4i a, vec4i b){
+	return a - b;
+}
+
+static inline vec4i vec4i_and(vec4i a, vec4i b){
+	return a & b;
+}
+
+static inline vec4i vec4i_shl(vec4i v, int n){
+	return v << n;
+}
+
+// arithmetic shift right (the sign bit is copied in from the left)
+static inline vec4i vec4i_sra(vec4i v, int n){
+	return v >> n;
+}
+
+// the bits of each float lane as an int, and back again
+static inline vec4i vec4_bits(vec4 v){
+	return (vec4i)v;
+}
+
+static inline vec4 vec4i_bits(vec4i v){
+	return (vec4)v;
+}
+
+// convert the value of each int lane to a float, and each float lane to an int (rounding toward 0)
+static inline vec4 vec4i_tofloat(vec4i v){
+	return __builtin_convertvector(v, vec4);
+}
+
+static inline vec4i vec4_toint(vec4 v){
+	return __builtin_convertvector(v, vec4i);
+}
+
+#else
+
+typedef struct {
+	float v[4];
+} vec4;
+
+static inline vec4 vec4_set(float a, float b, float c, float d){
+	return (vec4){{ a, b, c, d }};
+}
+
+static inline vec4 vec4_set1(float v){
+	return (vec4){{ v, v, v, v }};
+}
+
+static inline float vec4_get(vec4 v, int i){
+	return v.v[i];
+}
+
+static inline vec4 vec4_add(vec4 a, vec4 b){
+	return (vec4){{ a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] }};
+}
+
+static inline vec4 vec4_sub(vec4 a, vec4 b){
+	return (vec4){{ a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] }};
+}
+
+static inline vec4 vec4_mul(vec4 a, vec4 b){
+	return (vec4){{ a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] }};
+}
+
+static inline vec4 vec4_div(vec4 a, vec4 b){
+	return (vec4){{ a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3] }};
+}
+
+typedef struct {
+	bool v[4];
+} vec4mask;
+
+static inline vec4mask vec4_lt(vec4 a, vec4 b){
+	return (vec4mask){{ a.v[0] < b.v[0], a.v[1] < b.v[1], a.v[2] < b.v[2], a.v[3] < b.v[3] }};
+}
+
+static inline vec4mask vec4_gt(vec4 a, vec4 b){
+	return vec4_lt(b, a);
+}
+
+static inline vec4 vec4_select(vec4mask mask, vec4 a, vec4 b){
+	return (vec4){{
+		mask.v[0] ? a.v[0] : b.v[0],
+		mask.v[1] ? a.v[1] : b.v[1],
+		mask.v[2] ? a.v[2] : b.v[2],
+		mask.v[3] ? a.v[3] : b.v[3]
+	}};
+}
+
+static inline vec4 vec4_abs(vec4 v){
+	return (vec4){{
+		v.v[0] < 0.0f ? -v.v[0] : v.v[0],
+		v.v[1] < 0.0f ? -v.v[1] : v.v[1],
+		v.v[2] < 0.0f ? -v.v[2] : v.v[2],
+		v.v[3] < 0.0f ? -v.v[3] : v.v[3]
+	}};
+}
+
+typedef struct {
+	int32_t v[4];
+} vec4i;
+
+static inline vec4i vec4i_set1(int v){
+	return (vec4i){{ v, v, v, v }};
+}
+
+static inline int vec4i_get(vec4i v, int i){
+	return v.v[i];
+}
+
+static inline vec4i vec4i_add(vec4i a, vec4i b){
+	return (vec4i){{ a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] }};
+}
+
+static inline vec4i vec4i_sub(vec4i a, vec4i b){
+	return (vec4i){{ a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] }};
+}
+
+static inline vec4i vec4i_and(vec4i a, vec4i b){
+	return (vec4i){{ a.v[0] & b.v[0], a.v[1] & b.v[1], a.v[2] & b.v[2], a.v[3] & b.v[3] }};
+}
+
+static inline vec4i vec4i_shl(vec4i v, int n){
+	return (vec4i){{ v.v[0] << n, v.v[1] << n, v.v[2] << n, v.v[3] << n }};
+}
+
+static inline vec4i vec4i_sra(vec4i v, int n){
+	return (vec4i){{ v.v[0] >> n, v.v[1] >> n, v.v[2] >> n, v.v[3] >> n }};
+}
+
+static inline vec4i vec4_bits(vec4 v){
+	vec4i r;
+	memcpy(&r, &v, sizeof(r));
+	return r;
+}
+
+static inline vec4 vec4i_bits(vec4i v){
+	vec4 r;
+	memcpy(&r, &v, sizeof(r));
+	return r;
+}
+
+static inline vec4 vec4i_tofloat(vec4i v){
+	return (vec4){{ (float)v.v[0], (float)v.v[1], (float)v.v[2], (float)v.v[3] }};
+}
+
+static inline vec4i vec4_toint(vec4 v){
+	return (vec4i){{ (int32_t)v.v[0], (int32_t)v.v[1], (int32_t)v.v[2], (int32_t)v.v[3] }};
+}
+
+#endif // SF_SIMD
+
+// sin and cos of each lane, for values between -pi/4 and pi/4
+// this is the same polynomial as fast_sincosf in fastmath.h (without the range reduction), so the
+// max absolute error is 1e-6
+static inline void vec4_sincos(vec4 x, vec4 *s, vec4 *c){
+	vec4 x2 = vec4_mul(x, x);
+	vec4 x4 = vec4_mul(x2, x2);
+	*s = vec4_mul(x, vec4_add(
+		vec4_sub(vec4_set1(1.0f), vec4_mul(vec4_set1(1.6666667e-1f), x2)),
+		vec4_mul(vec4_sub(vec4_set1(8.3333333e-3f), vec4_mul(vec4_set1(1.9841270e-4f), x2)), x4)));
+	*c = vec4_add(
+		vec4_sub(vec4_set1(1.0f), vec4_mul(vec4_set1(0.5f), x2)),
+		vec4_mul(vec4_add(
+			vec4_sub(vec4_set1(4.1666667e-2f), vec4_mul(vec4_set1(1.3888889e-3f), x2)),
+			vec4_mul(vec4_set1(2.4801587e-5f), x4)), x4));
+}
+
+// atan2(y, x) of each lane
+// this is the same approximation as fast_atan2f in fastmath.h, so the max absolute error is 3e-7
+static inline vec4 vec4_atan2(vec4 y, vec4 x){
+	vec4 zero = vec4_set1(0.0f);
+	vec4 ax = vec4_abs(x);
+	vec4 ay = vec4_abs(y);
+	vec4mask ybig = vec4_gt(ay, ax);
+	vec4 hi = vec4_select(ybig, ay, ax);
+	vec4 lo = vec4_select(ybig, ax, ay);
+	vec4mask big = vec4_gt(lo, vec4_mul(vec4_set1(0.41421356f), hi));
+	vec4 num = vec4_select(big, vec4_sub(lo, hi), lo);
+	vec4 den = vec4_select(big, vec4_add(lo, hi), hi);
+	// avoid 0/0 when both x and y are 0 (the result is 0 in that case)
+	vec4 t = vec4_div(num, vec4_select(vec4_gt(den, zero), den, vec4_set1(1.0f)));
+	vec4 z = vec4_mul(t, t);
+	vec4 p = vec4_sub(vec4_mul(vec4_add(vec4_mul(vec4_sub(
+		vec4_mul(vec4_set1(8.05374449538e-2f), z),
+		vec4_set1(1.38776856032e-1f)), z),
+		vec4_set1(1.99777106478e-1f)), z),
+		vec4_set1(3.33329491539e-1f));
+	vec4 a = vec4_add(vec4_select(big, vec4_set1(0.78539816f), zero),
+		vec4_add(t, vec4_mul(vec4_mul(t, z), p)));
+	a = vec4_select(ybig, vec4_sub(vec4_set1(1.57079633f), a), a);
+	a = vec4_select(vec4_lt(x, zero), vec4_sub(vec4_set1(3.14159265f), a), a);
+	return vec4_select(vec4_lt(y, zero), vec4_sub(zero, a), a);
+}
+
+// round each lane to the nearest integer, for values less than 2^22
+// (adding and subtracting 1.5 * 2^23 pushes the fraction bits out of the float)
+static inline vec4 vec4_round(vec4 x){
+	return vec4_sub(vec4_add(x, vec4_set1(12582912.0f)), vec4_set1(12582912.0f));
+}
+
+// 2^x of each lane, for values between -126 and 127
+// this is the same approximation as fast_exp2f in fastmath.h, so the max relative error is 2e-7
+static inline vec4 vec4_exp2(vec4 x){
+	x = vec4_select(vec4_lt(x, vec4_set1(-126.0f)), vec4_set1(-126.0f), x);
+	x = vec4_select(vec4_gt(x, vec4_set1(127.0f)), vec4_set1(127.0f), x);
+	vec4 i = vec4_round(x);
+	vec4 f = vec4_sub(x, i); // fraction in [-0.5, 0.5]
+	vec4 p = vec4_add(vec4_set1(1.3333558e-3f), vec4_mul(f, vec4_set1(1.5403530e-4f)));
+	p = vec4_add(vec4_set1(9.6181291e-3f), vec4_mul(f, p));
+	p = vec4_add(vec4_set1(5.5504109e-2f), vec4_mul(f, p));
+	p = vec4_add(vec4_set1(2.4022651e-1f), vec4_mul(f, p));
+	p = vec4_add(vec4_set1(6.9314718e-1f), vec4_mul(f, p));
+	p = vec4_add(vec4_set1(1.0f), vec4_mul(f, p));
+	// build 2^i directly in the exponent bits
+	return vec4_mul(p, vec4i_bits(vec4i_shl(vec4i_add(vec4_toint(i), vec4i_set1(127)), 23)));
+}
+
+// unaligned load/store of 4 floats
+static inline vec4 vec4_load(const float *p){
+	vec4 v;
+	memcpy(&v, p, sizeof(vec4));
+	return v;
+}
+
+static inline void vec4_store(float *p, vec4 v){
+	memcpy(p, &v, sizeof(vec4));
+}
+
+// move a stereo sample into the first two lanes (the other two lanes are zero)
+static inline vec4 vec4_fromsample(sf_sample_st s){
+	return vec4_set(s.L, s.R, 0.0f, 0.0f);
+}
+
+// move a stereo sample into both halves of the vector (L, R, L, R)
+static inline vec4 vec4_dupsample(sf_sample_st s){
+	return vec4_set(s.L, s.R, s.L, s.R);
+}
+
+// pull the first two lanes back out as a stereo sample
+static inline sf_sample_st vec4_tosample(vec4 v){
+	return (sf_sample_st){ vec4_get(v, 0), vec4_get(v, 1) };
+}
+
+// load two consecutive stereo samples (L0, R0, L1, R1)
+static inline vec4 vec4_loadsamples(const sf_sample_st *s){
+	return vec4_load(&s->L);
+}
+
+// store two consecutive stereo samples
+static inline void vec4_storesamples(sf_sample_st *s, vec4 v){
+	vec4_store(&s->L, v);
+}
+
+#endif // SNDFILTER_SIMD__H
@@ -0,0 +1,240 @@
+// (c) Copyright 2016, Sean Connelly (@voidqk), http://syntheti.cc
+// MIT License
+// Project Home: https://github.com/voidqk/sndfilter
+
+#include "svf.h"
+#include "simd.h"
+#include "denormal.h"
+#include <math.h>
+
+// the SVF is two trapezoidal integrators in a loop, and each sample works like this:
+//
+//   v3 = v0 - ic2eq
+//   v1 = a1 * ic1eq + a2 * v3          (bandpass)
+//   v2 = ic2eq + a2 * ic1eq + a3 * v3  (lowpass)
+//   ic1eq = 2 * v1 - ic1eq
+//   ic2eq = 2 * v2 - ic2eq
+//
+// where v0 is the input, and the output is a mix of v0, v1, and v2 that depends on the type of
+// filter (for example, the highpass is v0 - k * v1 - v2)
+//
+// the coefficients come from g = tan(pi * freq / rate) and the damping k:
+//
+//   a1 = 1 / (1 + g * (g + k))
+//   a2 = g * a1
+//   a3 = g * a2
+//
+// writing g as S / C (where S and C are the sin and cos of the angle), all three share a single
+// division:
+//
+//   a1 = C^2 / D,  a2 = S * C / D,  a3 = S^2 / D,  where D = C^2 + S^2 + k * S * C
+//
+// so changing the frequency only costs a sin/cos approximation and a division -- and the
+// approximation is done on four frequencies at once, which is what makes per-sample modulation
+// cheap
+
+// calculate the coefficients for four frequencies at once
+static inline void svf_coefs(vec4 freq, float wscale, float gscale, float k, vec4 *a1, vec4 *a2,
+	vec4 *a3){
+	vec4 zero = vec4_set1(0.0f);
+	vec4 halfpi = vec4_set1(1.57079633f);
+
+	// angle between 0 and pi/2 (0Hz to nyquist)
+	vec4 x = vec4_mul(freq, vec4_set1(wscale));
+	x = vec4_select(vec4_lt(x, zero), zero, x);
+	x = vec4_select(vec4_gt(x, halfpi), halfpi, x);
+
+	// the sin and cos of the half angle are inside the range of vec4_sincos, so double them up
+	vec4 sh, ch;
+	vec4_sincos(vec4_mul(x, vec4_set1(0.5f)), &sh, &ch);
+	vec4 S = vec4_mul(vec4_set1(2.0f * gscale), vec4_mul(sh, ch));
+	vec4 C = vec4_sub(vec4_mul(ch, ch), vec4_mul(sh, sh));
+
+	vec4 CC = vec4_mul(C, C);
+	vec4 SC = vec4_mul(S, C);
+	vec4 SS = vec4_mul(S, S);
+	vec4 Dinv = vec4_div(vec4_set1(1.0f),
+		vec4_add(vec4_add(CC, SS), vec4_mul(vec4_set1(k), SC)));
+	*a1 = vec4_mul(CC, Dinv);
+	*a2 = vec4_mul(SC, Dinv);
+	*a3 = vec4_mul(SS, Dinv);
+}
+
+void sf_svf_setfreq(sf_svf_state_st *state, float freq){
+	vec4 a1, a2, a3;
+	svf_coefs(vec4_set1(freq), state->wscale, state->gscale, state->k, &a1, &a2, &a3);
+	state->a1 = vec4_get(a1, 0);
+	state->a2 = vec4_get(a2, 0);
+	state->a3 = vec4_get(a3, 0);
+}
+
+// the output mixes and damping for each type of filter are from Andrew Simper's paper (linked in
+// svf.h), with the parameters converted to match the biquad designs in biquad.c
+void sf_svf_design(sf_svf_state_st *state, sf_biquad_type type, int rate, float freq, float Q,
+	float gain){
+	state->ic1eq = (sf_sample_st){ 0, 0 };
+	state->ic2eq = (sf_sample_st){ 0, 0 };
+	state->wscale = (float)M_PI / (float)rate;
+	state->gscale = 1.0f;
+
+	// a Q of 0 would mean infinite damping, so keep it just above 0 (this gives the same result as
+	// the biquads do for a Q of 0)
+	if (Q < 1e-4f && type != SF_BIQUAD_LOWPASS && type != SF_BIQUAD_HIGHPASS)
+		Q = 1e-4f;
+
+	float A = powf(10.0f, gain * 0.025f); // square root of gain converted from dB to linear
+	float k;
+	switch (type){
+		case SF_BIQUAD_LOWPASS:
+			k = 1.0f / powf(10.0f, Q * 0.05f); // convert resonance from dB to linear
+			state->m0 = 0.0f;
+			state->m1 = 0.0f;
+			state->m2 = 1.0f;
+			break;
+		case SF_BIQUAD_HIGHPASS:
+			k = 1.0f / powf(10.0f, Q * 0.05f);
+			state->m0 = 1.0f;
+			state->m1 = -k;
+			state->m2 = -1.0f;
+			break;
+		case SF_BIQUAD_BANDPASS:
+			k = 1.0f / Q;
+			state->m0 = 0.0f;
+			state->m1 = k;
+			state->m2 = 0.0f;
+			break;
+		case SF_BIQUAD_NOTCH:
+			k = 1.0f / Q;
+			state->m0 = 1.0f;
+			state->m1 = -k;
+			state->m2 = 0.0f;
+			break;
+		case SF_BIQUAD_PEAKING:
+			k = 1.0f / (Q * A);
+			state->m0 = 1.0f;
+			state->m1 = k * (A * A - 1.0f);
+			state->m2 = 0.0f;
+			break;
+		case SF_BIQUAD_ALLPASS:
+			k = 1.0f / Q;
+			state->m0 = 1.0f;
+			state->m1 = -2.0f * k;
+			state->m2 = 0.0f;
+			break;
+		case SF_BIQUAD_LOWSHELF:
+		case SF_BIQUAD_HIGHSHELF:{
+			// the biquad shelves treat Q as the shelf slope, which converts to a damping of:
+			float ainn = (A + 1.0f / A) * (1.0f / Q - 1.0f) + 2.0f;
+			k = sqrtf(ainn < 0.0f ? 0.0f : ainn);
+			if (type == SF_BIQUAD_LOWSHELF){
+				state->gscale = 1.0f / sqrtf(A);
+				state->m0 = 1.0f;
+				state->m1 = k * (A - 1.0f);
+				state->m2 = A * A - 1.0f;
+			}
+			else{
+				state->gscale = sqrtf(A);
+				state->m0 = A * A;
+				state->m1 = k * (1.0f - A) * A;
+				state->m2 = 1.0f - A * A;
+			}
+		} break;
+		default:
+			// unknown type, so just pass the sound through
+			k = 1.0f;
+			state->m0 = 1.0f;
+			state->m1 = 0.0f;
+			state->m2 = 0.0f;
+			break;
+	}
+	state->k = k;
+	sf_svf_setfreq(state, freq);
+}
+
+// one sample for both channels, in the first two lanes of the vectors
+static inline vec4 svf_step(vec4 v0, vec4 a1, vec4 a2, vec4 a3, vec4 m0, vec4 m1, vec4 m2,
+	vec4 *ic1eq, vec4 *ic2eq){
+	vec4 two = vec4_set1(2.0f);
+	vec4 v3 = vec4_sub(v0, *ic2eq);
+	vec4 v1 = vec4_add(vec4_mul(a1, *ic1eq), vec4_mul(a2, v3));
+	vec4 v2 = vec4_add(vec4_add(*ic2eq, vec4_mul(a2, *ic1eq)), vec4_mul(a3, v3));
+	*ic1eq = vec4_sub(vec4_mul(two, v1), *ic1eq);
+	*ic2eq = vec4_sub(vec4_mul(two, v2), *ic2eq);
+	return vec4_add(vec4_add(vec4_mul(m0, v0), vec4_mul(m1, v1)), vec4_mul(m2, v2));
+}
+
+void sf_svf_process(sf_svf_state_st *state, int size, sf_sample_st *input, sf_sample_st *output){
+	uint64_t ftz = ftz_begin();
+
+	// pull out the state into vector registers
+	vec4 a1 = vec4_set1(state->a1);
+	vec4 a2 = vec4_set1(state->a2);
+	vec4 a3 = vec4_set1(state->a3);
+	vec4 m0 = vec4_set1(state->m0);
+	vec4 m1 = vec4_set1(state->m1);
+	vec4 m2 = vec4_set1(state->m2);
+	vec4 ic1eq = vec4_fromsample(state->ic1eq);
+	vec4 ic2eq = vec4_fromsample(state->ic2eq);
+
+	// loop for each sample
+	for (int n = 0; n < size; n++){
+		vec4 v0 = vec4_fromsample(input[n]);
+		output[n] = vec4_tosample(svf_step(v0, a1, a2, a3, m0, m1, m2, &ic1eq, &ic2eq));
+	}
+
+	// save the state for future processing
+	state->ic1eq = vec4_tosample(ic1eq);
+	state->ic2eq = vec4_tosample(ic2eq);
+	ftz_end(ftz);
+}
+
+void sf_svf_process_mod(sf_svf_state_st *state, int size, sf_sample_st *input,
+	sf_sample_st *output, const float *freq){
+	if (size <= 0)
+		return;
+	uint64_t ftz = ftz_begin();
+
+	// pull out the state into vector registers
+	vec4 m0 = vec4_set1(state->m0);
+	vec4 m1 = vec4_set1(state->m1);
+	vec4 m2 = vec4_set1(state->m2);
+	vec4 ic1eq = vec4_fromsample(state->ic1eq);
+	vec4 ic2eq = vec4_fromsample(state->ic2eq);
+	vec4 a1, a2, a3;
+
+	// the coefficients for four samples are calculated at once, one sample per lane, and then the
+	// four samples are processed one at a time
+	int n = 0;
+	for (; n + 4 <= size; n += 4){
+		svf_coefs(vec4_load(&freq[n]), state->wscale, state->gscale, state->k, &a1, &a2, &a3);
+		for (int i = 0; i < 4; i++){
+			vec4 v0 = vec4_fromsample(input[n + i]);
+			output[n + i] = vec4_tosample(svf_step(v0,
+				vec4_set1(vec4_get(a1, i)), vec4_set1(vec4_get(a2, i)), vec4_set1(vec4_get(a3, i)),
+				m0, m1, m2, &ic1eq, &ic2eq));
+		}
+	}
+	int last = 3;
+	if (n < size){
+		// leftover samples, padded by repeating the last frequency
+		float fl[4];
+		for (int i = 0; i < 4; i++)
+			fl[i] = freq[n + i < size ? n + i : size - 1];
+		svf_coefs(vec4_load(fl), state->wscale, state->gscale, state->k, &a1, &a2, &a3);
+		for (int i = 0; n + i < size; i++){
+			vec4 v0 = vec4_fromsample(input[n + i]);
+			output[n + i] = vec4_tosample(svf_step(v0,
+				vec4_set1(vec4_get(a1, i)), vec4_set1(vec4_get(a2, i)), vec4_set1(vec4_get(a3, i)),
+				m0, m1, m2, &ic1eq, &ic2eq));
+		}
+		last = size - n - 1;
+	}
+
+	// save the state for future processing, with the coefficients of the last sample
+	state->a1 = vec4_get(a1, last);
+	state->a2 = vec4_get(a2, last);
+	state->a3 = vec4_get(a3, last);
+	state->ic1eq = vec4_tosample(ic1eq);
+	state->ic2eq = vec4_tosample(ic2eq);
+	ftz_end(ftz);
+}
@@ -0,0 +1,75 @@
+// (c) Copyright 2016, Sean Connelly (@voidqk), http://syntheti.cc
+// MIT License
+// Project Home: https://github.com/voidqk/sndfilter
+
+// state variable filtering based on Andrew Simper's (Cytomic) trapezoidal integrator SVF:
+//   https://cytomic.com/files/dsp/SvfLinearTrapOptimised2.pdf
+
+#ifndef SNDFILTER_SVF__H
+#define SNDFILTER_SVF__H
+
+#include "snd.h"
+#include "biquad.h"
+
+// a state variable filter (SVF) produces the same kinds of filters as the biquads in biquad.h, but
+// it's built differently on the inside, which makes it a much better fit for sweeping the frequency
+// while the sound is playing (like a synthesizer filter controlled by an envelope or an LFO)
+//
+// a biquad stores its state as past input and output samples, which only make sense for the
+// coefficients that produced them -- so changing the frequency quickly can cause clicks or even
+// make the filter blow up; the SVF stores its state as the charge of two integrators, which stays
+// meaningful when the frequency changes, so it can be changed on every single sample
+//
+// changing the frequency is also cheap, since it only needs a sin/cos approximation and a single
+// division, instead of designing a whole new set of biquad coefficients
+//
+// for example, for a lowpass filter over a stream with 128 samples per chunk, you would do:
+//
+//   sf_svf_state_st svf;
+//   sf_svf_design(&svf, SF_BIQUAD_LOWPASS, 44100, 440, 0, 0);
+//
+//   for each 128 length sample:
+//     sf_svf_process(&svf, 128, input, output);
+//
+// or, to sweep the cutoff, fill an array with the cutoff for each sample, and use
+// sf_svf_process_mod instead
+//
+// note that the frequencies here are the actual frequencies in the sound; the biquad designs in
+// biquad.h place their frequency at twice the value given (for example, sf_lowpass with a cutoff of
+// 440 has the same response as an SVF lowpass with a cutoff of 880)
+
+typedef struct {
+	float a1;     // integrator coefficients, calculated from the frequency and the damping
+	float a2;
+	float a3;
+	float m0;     // how much of the input, bandpass, and lowpass are mixed into the output
+	float m1;
+	float m2;
+	float k;      // damping (1 / Q)
+	float gscale; // the shelves move their frequency by the gain
+	float wscale; // converts a frequency in Hz to an angle (pi / rate)
+	sf_sample_st ic1eq; // integrator states
+	sf_sample_st ic2eq;
+} sf_svf_state_st;
+
+// initialize an sf_svf_state_st structure for a type of filter, with the same parameters as
+// sf_biquad_design (so for lowpass and highpass filters, `Q` is the resonance in dB, and `gain` is
+// ignored by the filters that don't have a gain parameter)
+void sf_svf_design(sf_svf_state_st *state, sf_biquad_type type, int rate, float freq, float Q,
+	float gain);
+
+// change the frequency of the filter without touching anything else, which is cheap and keeps the
+// state of the integrators, so it can be called between chunks without any clicks
+void sf_svf_setfreq(sf_svf_state_st *state, float freq);
+
+// this function will process the input sound based on the state passed
+// the input and output buffers should be the same size, and can be the same buffer
+void sf_svf_process(sf_svf_state_st *state, int size, sf_sample_st *input, sf_sample_st *output);
+
+// same as sf_svf_process, but the frequency of the filter changes on every sample, where freq[i] is
+// the frequency (in Hz) for sample i
+// afterwards, the state is left at the last frequency, so sf_svf_process can pick up from there
+void sf_svf_process_mod(sf_svf_state_st *state, int size, sf_sample_st *input,
+	sf_sample_st *output, const float *freq);
+
+#endif // SNDFILTER_SVF__H